@@ -0,0 +1,297 @@
+#pragma once
+
+#include "atomic"
+#include "cstdint"
+#include "string"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include "windows.h"
+#else
+#include "fcntl.h"
+#include "sys/mman.h"
+#include "unistd.h"
+#endif
+
+
+//ring of frame slots in named shared memory, written by the simulator and read in place by any number of local
+//processes. each slot has a sequence counter which is odd while the slot is being written, so readers can tell if
+//the frame they are looking at was overwritten while they used it. the writer never waits for readers, slow readers
+//just miss frames
+
+enum FrameFormat : uint32_t
+{
+	FRAME_FORMAT_R32F = 1 //one float of trail strength per pixel, rows from y = 0 upwards
+};
+
+struct FrameRingHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t numSlots;
+	uint32_t slotBytes; //size of each slot including its header, data starts frameRingSlotHeaderBytes in
+	uint64_t maxFrameBytes;
+	std::atomic<uint64_t> latestFrame; //number of the newest complete frame, 0 before the first
+};
+
+struct FrameSlotHeader
+{
+	std::atomic<uint64_t> sequence; //2 * frame while complete, odd while being written
+	uint64_t frame;
+	uint64_t step; //sim step the frame was taken after
+	uint32_t width, height; //of the frame, which may be downsampled from the map
+	uint32_t mapWidth, mapHeight;
+	uint32_t format;
+	uint32_t padding;
+	uint64_t settingsHash; //changes whenever the sim settings do
+	uint64_t frameBytes;
+};
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "sequence counters must be lock free to be shared between processes");
+
+const uint32_t frameRingMagic = 0x534c4d52; //"SLMR"
+const uint32_t frameRingVersion = 1;
+const uint32_t frameRingHeaderBytes = 64;
+const uint32_t frameRingSlotHeaderBytes = 64;
+static_assert(sizeof(FrameRingHeader) <= frameRingHeaderBytes, "ring header too big");
+static_assert(sizeof(FrameSlotHeader) <= frameRingSlotHeaderBytes, "slot header too big");
+
+//frame being read in place from the ring, check it is still valid after using it
+struct FrameView
+{
+	const FrameSlotHeader* header = nullptr;
+	const void* data = nullptr;
+	uint64_t sequence = 0;
+};
+
+class FrameRing
+{
+public:
+	//writer side, replaces any existing ring with the same name
+	bool create(const std::string& name, uint32_t numSlots, uint64_t maxFrameBytes)
+	{
+		close();
+		uint64_t slotBytes = align(frameRingSlotHeaderBytes + maxFrameBytes);
+		if (slotBytes > UINT32_MAX) return false;
+
+		if (!map(name, frameRingHeaderBytes + numSlots * slotBytes, true)) return false;
+
+		FrameRingHeader* header = ringHeader();
+		header->magic = 0; //not valid until fully set up
+		header->version = frameRingVersion;
+		header->numSlots = numSlots;
+		header->slotBytes = (uint32_t)slotBytes;
+		header->maxFrameBytes = maxFrameBytes;
+		new (&header->latestFrame) std::atomic<uint64_t>(0);
+		for (uint32_t i = 0; i < numSlots; i++) new (&slotHeader(i)->sequence) std::atomic<uint64_t>(0);
+
+		std::atomic_thread_fence(std::memory_order_release);
+		header->magic = frameRingMagic;
+		writer = true;
+		nextFrame = 1;
+		return true;
+	}
+
+	//reader side, fails if the simulator hasn't created the ring yet
+	bool open(const std::string& name)
+	{
+		close();
+		if (!map(name, frameRingHeaderBytes, false)) return false;
+
+		const FrameRingHeader* header = ringHeader();
+		if (header->magic != frameRingMagic || header->version != frameRingVersion)
+		{
+			close();
+			return false;
+		}
+
+		//map again now the full size is known
+		uint64_t size = frameRingHeaderBytes + (uint64_t)header->numSlots * header->slotBytes;
+		close();
+		return map(name, size, false);
+	}
+
+	void close()
+	{
+		if (base != nullptr)
+		{
+#ifdef _WIN32
+			UnmapViewOfFile(base);
+#else
+			munmap(base, mappedBytes);
+			if (writer) shm_unlink(mappedName.c_str());
+#endif
+		}
+#ifdef _WIN32
+		if (mapping != NULL) CloseHandle(mapping);
+		mapping = NULL;
+#endif
+		base = nullptr;
+		mappedBytes = 0;
+		writer = false;
+	}
+
+	bool isOpen() const
+	{
+		return base != nullptr;
+	}
+
+	uint64_t maxFrameBytes() const
+	{
+		return ringHeader()->maxFrameBytes;
+	}
+
+	//writer: get the next slot to write a frame straight into, then call endFrame once it has been filled
+	void* beginFrame(uint64_t step, uint32_t width, uint32_t height, uint32_t mapWidth, uint32_t mapHeight,
+		FrameFormat format, uint64_t settingsHash, uint64_t frameBytes)
+	{
+		FrameSlotHeader* slot = slotHeader(nextFrame % ringHeader()->numSlots);
+
+		//odd sequence tells readers the slot is changing
+		slot->sequence.store(2 * nextFrame - 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		slot->frame = nextFrame;
+		slot->step = step;
+		slot->width = width;
+		slot->height = height;
+		slot->mapWidth = mapWidth;
+		slot->mapHeight = mapHeight;
+		slot->format = format;
+		slot->settingsHash = settingsHash;
+		slot->frameBytes = frameBytes;
+		return slotData(slot);
+	}
+
+	void endFrame()
+	{
+		FrameSlotHeader* slot = slotHeader(nextFrame % ringHeader()->numSlots);
+		slot->sequence.store(2 * nextFrame, std::memory_order_release);
+		ringHeader()->latestFrame.store(nextFrame, std::memory_order_release);
+		nextFrame++;
+	}
+
+	//reader: newest complete frame, false if there isn't one yet
+	bool latestFrame(FrameView& view) const
+	{
+		for (int attempt = 0; attempt < 4; attempt++)
+		{
+			uint64_t frame = ringHeader()->latestFrame.load(std::memory_order_acquire);
+			if (frame == 0) return false;
+
+			const FrameSlotHeader* slot = slotHeader(frame % ringHeader()->numSlots);
+			uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+
+			//if the writer has already lapped the ring back round to this slot, try again with the newer frame
+			if (sequence != 2 * frame) continue;
+
+			view.header = slot;
+			view.data = slotData(slot);
+			view.sequence = sequence;
+			return true;
+		}
+
+		return false;
+	}
+
+	//reader: true if nothing has overwritten the frame since latestFrame returned it
+	bool stillValid(const FrameView& view) const
+	{
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return view.header->sequence.load(std::memory_order_relaxed) == view.sequence;
+	}
+
+	~FrameRing()
+	{
+		close();
+	}
+
+private:
+	void* base = nullptr;
+	uint64_t mappedBytes = 0;
+	bool writer = false;
+	uint64_t nextFrame = 1;
+	std::string mappedName;
+#ifdef _WIN32
+	HANDLE mapping = NULL;
+#endif
+
+	static uint64_t align(uint64_t bytes)
+	{
+		return (bytes + 63) & ~(uint64_t)63;
+	}
+
+	FrameRingHeader* ringHeader() const
+	{
+		return (FrameRingHeader*)base;
+	}
+
+	FrameSlotHeader* slotHeader(uint64_t slot) const
+	{
+		return (FrameSlotHeader*)((char*)base + frameRingHeaderBytes + slot * ringHeader()->slotBytes);
+	}
+
+	static void* slotData(const FrameSlotHeader* slot)
+	{
+		return (char*)slot + frameRingSlotHeaderBytes;
+	}
+
+	bool map(const std::string& name, uint64_t bytes, bool create)
+	{
+#ifdef _WIN32
+		std::string windowsName = "Local\\" + (name[0] == '/' ? name.substr(1) : name);
+		if (create)
+		{
+			mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)(bytes >> 32),
+				(DWORD)(bytes & 0xffffffff), windowsName.c_str());
+		}
+		else
+		{
+			mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, windowsName.c_str());
+		}
+		if (mapping == NULL) return false;
+
+		//an existing mapping is returned with its old size and contents, so another writer is already using the name
+		if (create && GetLastError() == ERROR_ALREADY_EXISTS)
+		{
+			CloseHandle(mapping);
+			mapping = NULL;
+			return false;
+		}
+
+		base = MapViewOfFile(mapping, create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, bytes);
+		if (base == nullptr)
+		{
+			CloseHandle(mapping);
+			mapping = NULL;
+			return false;
+		}
+#else
+		if (create) shm_unlink(name.c_str()); //start from a clean ring rather than one left by a crashed run
+
+		int file = shm_open(name.c_str(), create ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+		if (file < 0) return false;
+
+		//reserve the pages up front, shared memory is often small and running out of it later would kill the writer
+		//with SIGBUS partway through a frame rather than failing here
+		if (create && posix_fallocate(file, 0, bytes) != 0)
+		{
+			::close(file);
+			shm_unlink(name.c_str());
+			return false;
+		}
+
+		void* mapped = mmap(NULL, bytes, create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file, 0);
+		::close(file); //the mapping keeps the shared memory alive
+		if (mapped == MAP_FAILED)
+		{
+			if (create) shm_unlink(name.c_str());
+			return false;
+		}
+		base = mapped;
+#endif
+		mappedBytes = bytes;
+		mappedName = name;
+		return true;
+	}
+};
@@ -0,0 +1,81 @@
+
+//reference consumer for the frames slimecl publishes with "Publish Frames" turned on. reads each new frame in place
+//from shared memory and prints a summary of it
+//build separately from the simulator, e.g. on linux: g++ -std=c++14 -O2 frame_viewer.cpp -o frame_viewer -lrt
+//usage: frame_viewer [ring name] [number of frames to read before exiting]
+
+#include "chrono"
+#include "iostream"
+#include "string"
+#include "thread"
+
+#include "frame_ring.hpp"
+
+
+int main(int argc, char** argv)
+{
+	std::string name = argc > 1 ? argv[1] : "/slimecl_frames";
+	long long framesToRead = argc > 2 ? std::stoll(argv[2]) : -1;
+
+	FrameRing ring;
+	uint64_t lastFrame = 0;
+	uint64_t skipped = 0;
+	uint64_t torn = 0;
+	std::chrono::steady_clock::time_point lastNewFrame = std::chrono::steady_clock::now();
+
+	while (framesToRead != 0)
+	{
+		if (!ring.isOpen())
+		{
+			if (!ring.open(name))
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(500));
+				continue;
+			}
+
+			if (lastFrame == 0) std::cout << "Opened " << name << std::endl;
+			lastNewFrame = std::chrono::steady_clock::now();
+		}
+
+		FrameView view;
+		if (ring.latestFrame(view) && view.header->frame != lastFrame)
+		{
+			uint64_t frame = view.header->frame;
+			uint64_t step = view.header->step;
+			uint32_t width = view.header->width;
+			uint32_t height = view.header->height;
+			uint64_t settingsHash = view.header->settingsHash;
+
+			double total = 0.0;
+			if (view.header->format == FRAME_FORMAT_R32F)
+			{
+				const float* trail = (const float*)view.data;
+				for (uint64_t i = 0; i < (uint64_t)width * height; i++) total += trail[i];
+			}
+
+			//the simulator doesn't wait for us, so throw away anything it overwrote while we were reading
+			if (!ring.stillValid(view))
+			{
+				torn++;
+				continue;
+			}
+
+			if (lastFrame != 0 && frame > lastFrame) skipped += frame - lastFrame - 1;
+			lastFrame = frame;
+			lastNewFrame = std::chrono::steady_clock::now();
+			if (framesToRead > 0) framesToRead--;
+
+			std::cout << "frame " << frame << " step " << step << " " << width << "x" << height << " settings "
+				<< std::hex << settingsHash << std::dec << " mean trail " << total / ((double)width * height)
+				<< " skipped " << skipped << " torn " << torn << std::endl;
+		}
+		else
+		{
+			//a restarted simulator makes a new ring, so reopen if this one has gone quiet
+			if (std::chrono::steady_clock::now() - lastNewFrame > std::chrono::seconds(2)) ring.close();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+
+	return 0;
+}
@@ -4,6 +4,7 @@
 string opencl_c_container() {
 return R( // ########################## begin of OpenCL C code ####################################################################
 
+	//must match sim_settings.hpp
 	typedef struct SlimeSettings
 	{
 		float slimeSpeed;
@@ -19,6 +20,42 @@ return R( // ########################## begin of OpenCL C code #################
 		float blurRate;
 		float decayRate;
 		float r, g, b;
+		int diffusionMode;
+		int diffusionRadius;
+		float diffusionSigma;
+	};
+
+	enum StatsLayout
+	{
+		//must match the StatsLayout enum in main.cpp
+		STATS_GROUP_SIZE = 64,
+		STATS_NUM_GROUPS = 256,
+		DENSITY_BINS_X = 8,
+		DENSITY_BINS_Y = 8,
+		DENSITY_BINS = DENSITY_BINS_X * DENSITY_BINS_Y,
+
+		//indices into statCounts, which is accumulated with atomics during a sample
+		STAT_COUNT_COVERAGE = 0,
+		STAT_COUNT_TURN = 1, //left, straight, right
+		STAT_COUNT_DENSITY = 4,
+		STAT_COUNTS_SIZE = STAT_COUNT_DENSITY + DENSITY_BINS,
+
+		//indices into the final stats buffer which is read back by the host
+		STAT_TRAIL_MASS = 0,
+		STAT_COVERAGE = 1,
+		STAT_SENSOR_STRENGTH = 2,
+		STAT_TURN = 3,
+		STAT_DENSITY = 6,
+		STATS_SIZE = STAT_DENSITY + DENSITY_BINS
+	};
+
+	enum BlurLayout
+	{
+		//must match the BlurLayout enum in sim_settings.hpp
+		BLUR_ROW_TILE = 256, //pixels of a row blurred by each work group of blurRows
+		BLUR_ROW_GROUP = 128, //work items in each work group of blurRows
+		BLUR_MAX_RADIUS = 64, //largest radius of a single pass, the pixels either side of a row tile held in local memory
+		BLUR_COLUMN_RUN = 32 //rows of a column blurred by each work item of blurColumns
 	};
 
 	int wrap(int x, const int period)
@@ -31,9 +68,9 @@ return R( // ########################## begin of OpenCL C code #################
 	float2 wrapPos(float2 pos, int mapWidth, int mapHeight)
 	{
 		while (pos.x < 0) pos.x += mapWidth;
-		while (pos.x > mapWidth) pos.x -= mapWidth;
+		while (pos.x >= mapWidth) pos.x -= mapWidth;
 		while (pos.y < 0) pos.y += mapHeight;
-		while (pos.y > mapHeight) pos.y -= mapHeight;
+		while (pos.y >= mapHeight) pos.y -= mapHeight;
 		return pos;
 	}
 
@@ -60,6 +97,36 @@ return R( // ########################## begin of OpenCL C code #################
 		return (float2)(vec.x * cos(angle) - vec.y * sin(angle), vec.x * sin(angle) + vec.y * cos(angle));
 	}
 
+	float decayValue(float current, float average, float simDeltaTime, struct TrailSettings trailSettings)
+	{
+		float weight = trailSettings.blurRate * simDeltaTime;
+		float weightedAverage = (1.0f - weight) * current + weight * average;
+		return max(0.0f, weightedAverage - trailSettings.decayRate * simDeltaTime);
+	}
+
+	float decayPixel(global float* trailMap, int x, int y, int yUp, int yDown, int mapWidth, float simDeltaTime,
+		struct TrailSettings trailSettings)
+	{
+		//y, yUp and yDown are rows within trailMap, which may be the whole map or a band of it
+		int xLeft = wrap(x - 1, mapWidth);
+		int xRight = wrap(x + 1, mapWidth);
+
+		//3x3 box blur
+		float average = (
+			trailMap[yUp * mapWidth + xLeft] +
+			trailMap[yUp * mapWidth + x] +
+			trailMap[yUp * mapWidth + xRight] +
+			trailMap[y * mapWidth + xLeft] +
+			trailMap[y * mapWidth + x] +
+			trailMap[y * mapWidth + xRight] +
+			trailMap[yDown * mapWidth + xLeft] +
+			trailMap[yDown * mapWidth + x] +
+			trailMap[yDown * mapWidth + xRight]
+		) / 9.0f;
+
+		return decayValue(trailMap[y * mapWidth + x], average, simDeltaTime, trailSettings);
+	}
+
 	kernel void decayTrails(global float* trailMap, global float* nextTrailMap, global float4* colouredTrail,
 		int mapWidth, int mapHeight, float simDeltaTime, struct TrailSettings trailSettings)
 	{
@@ -68,51 +135,165 @@ return R( // ########################## begin of OpenCL C code #################
 		int x = mapPixelIndex % mapWidth;
 		int y = mapPixelIndex / mapWidth;
 
-		//3x3 box blur
-		int2 s1 = (int2)(wrap(x - 1, mapWidth), wrap(y - 1, mapHeight));
-		int2 s2 = (int2)(x,						wrap(y - 1, mapHeight));
-		int2 s3 = (int2)(wrap(x + 1, mapWidth), wrap(y - 1, mapHeight));
-		int2 s4 = (int2)(wrap(x - 1, mapWidth), y					  );
-		int2 s6 = (int2)(wrap(x + 1, mapWidth), y					  );
-		int2 s7 = (int2)(wrap(x - 1, mapWidth), wrap(y + 1, mapHeight));
-		int2 s8 = (int2)(x,						wrap(y + 1, mapHeight));
-		int2 s9 = (int2)(wrap(x + 1, mapWidth), wrap(y + 1, mapHeight));
-
-		float average = (
-			trailMap[s1.y * mapWidth + s1.x] +
-			trailMap[s2.y * mapWidth + s2.x] +
-			trailMap[s3.y * mapWidth + s3.x] +
-			trailMap[s4.y * mapWidth + s4.x] +
-			trailMap[mapPixelIndex] +
-			trailMap[s6.y * mapWidth + s6.x] +
-			trailMap[s7.y * mapWidth + s7.x] +
-			trailMap[s8.y * mapWidth + s8.x] +
-			trailMap[s9.y * mapWidth + s9.x]
-		) / 9.0f;
-
-		float current = trailMap[mapPixelIndex];
-		float weight = trailSettings.blurRate * simDeltaTime;
-		float weightedAverage = (1.0f - weight) * current + weight * average;
-		float decayed = max(0.0f, weightedAverage - trailSettings.decayRate * simDeltaTime);
+		float decayed = decayPixel(trailMap, x, y, wrap(y - 1, mapHeight), wrap(y + 1, mapHeight), mapWidth,
+			simDeltaTime, trailSettings);
 
 		nextTrailMap[mapPixelIndex] = decayed;
 		colouredTrail[mapPixelIndex] = (float4)(decayed * trailSettings.r, decayed * trailSettings.g, decayed * trailSettings.b, 1.0f);
 	}
 
-	kernel void updateSlimes(global float2* positions, global float2* directions, global float* trailMap,
-		global float* nextTrailMap, global uint* randomSeeds, int mapWidth, int mapHeight, float simDeltaTime,
-		struct SlimeSettings slimeSettings, int numSlimes)
+	kernel void decayTrailsBand(global float* trailBand, global float* nextTrailBand, int mapWidth, int bandRows,
+		float simDeltaTime, struct TrailSettings trailSettings)
 	{
-		const uint slimeIndex = get_global_id(0);
+		const uint bandPixelIndex = get_global_id(0);
 
-		if (slimeIndex >= numSlimes)
+		int x = bandPixelIndex % mapWidth;
+		int y = bandPixelIndex / mapWidth;
+
+		//the first and last rows of the band have no neighbours above/below, the host only keeps rows inside them
+		if (y < 1 || y >= bandRows - 1) return;
+
+		nextTrailBand[bandPixelIndex] = decayPixel(trailBand, x, y, y - 1, y + 1, mapWidth, simDeltaTime, trailSettings);
+	}
+
+)+R(
+
+	//wider diffusion is done as separable box blur passes, two kernels each, whose cost per pixel barely depends on
+	//the radius. rows are blurred from a prefix sum of a tile of the row in local memory, and columns by sliding a box
+	//sum down a run of rows, so neighbouring work items always read neighbouring pixels.
+	//several passes of these approximate a gaussian
+
+	kernel void blurRows(global float* src, global float* dst, int width, int rows, int radius)
+	{
+		//each work group blurs BLUR_ROW_TILE pixels of one row, which needs radius more pixels either side of them.
+		//rows always wrap
+		local float line[BLUR_ROW_TILE + 2 * BLUR_MAX_RADIUS];
+		local float chunkSums[BLUR_ROW_GROUP];
+		const int localIndex = get_local_id(0);
+		const int tilesPerRow = (width + BLUR_ROW_TILE - 1) / BLUR_ROW_TILE;
+		const int y = get_group_id(0) / tilesPerRow;
+		const int tileX = get_group_id(0) % tilesPerRow * BLUR_ROW_TILE;
+		if (y >= rows) return; //the whole group is on the same row, so returns together
+
+		const int length = BLUR_ROW_TILE + 2 * radius;
+		for (int i = localIndex; i < length; i += BLUR_ROW_GROUP)
 		{
-			//for some reason, at numslimes less than 128, extra slimes will be created up to 128, and start at 0,0 with
-			//a random positive direction...
-			//they are not present in the host buffer and the host memory object believes there to be the correct
-			//specified number so
-			return;
+			line[i] = src[y * width + wrap(tileX - radius + i, width)];
+		}
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		//each work item scans its own chunk of the line, then the chunk totals are scanned together and added back on
+		const int chunk = (length + BLUR_ROW_GROUP - 1) / BLUR_ROW_GROUP;
+		const int chunkStart = localIndex * chunk;
+		const int chunkEnd = min(chunkStart + chunk, length);
+		float sum = 0.0f;
+		for (int i = chunkStart; i < chunkEnd; i++)
+		{
+			sum += line[i];
+			line[i] = sum;
+		}
+		chunkSums[localIndex] = sum;
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		for (int offset = 1; offset < BLUR_ROW_GROUP; offset *= 2)
+		{
+			float before = localIndex >= offset ? chunkSums[localIndex - offset] : 0.0f;
+			barrier(CLK_LOCAL_MEM_FENCE);
+			chunkSums[localIndex] += before;
+			barrier(CLK_LOCAL_MEM_FENCE);
+		}
+
+		float chunkOffset = localIndex > 0 ? chunkSums[localIndex - 1] : 0.0f;
+		for (int i = chunkStart; i < chunkEnd; i++) line[i] += chunkOffset;
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		//line[i] is now the sum of the line up to and including i
+		float scale = 1.0f / (2 * radius + 1);
+		for (int i = localIndex; i < BLUR_ROW_TILE && tileX + i < width; i += BLUR_ROW_GROUP)
+		{
+			float before = i > 0 ? line[i - 1] : 0.0f;
+			dst[y * width + tileX + i] = (line[i + 2 * radius] - before) * scale;
+		}
+	}
+
+	kernel void blurColumns(global float* src, global float* dst, int width, int rows, int radius, int wrapRows)
+	{
+		//each work item does BLUR_COLUMN_RUN rows of one column, summing the first box in full and then adding the row
+		//entering the box and taking away the row leaving it
+		const int x = get_global_id(0) % width;
+		const int runStart = get_global_id(0) / width * BLUR_COLUMN_RUN;
+		if (runStart >= rows) return;
+
+		float scale = 1.0f / (2 * radius + 1);
+		float sum = 0.0f;
+		bool started = false;
+		for (int y = runStart; y < min(runStart + BLUR_COLUMN_RUN, rows); y++)
+		{
+			//bands don't wrap, only rows with the whole box inside the band are blurred and radius rows are lost from
+			//the top and bottom, which the band halo allows for. they are cleared rather than left as whatever was in
+			//the buffer, as the next pass sums down the whole column
+			if (!wrapRows && (y < radius || y >= rows - radius))
+			{
+				dst[y * width + x] = 0.0f;
+				continue;
+			}
+
+			if (!started)
+			{
+				for (int i = y - radius; i <= y + radius; i++) sum += src[wrap(i, rows) * width + x];
+				started = true;
+			}
+
+			dst[y * width + x] = sum * scale;
+			sum += src[wrap(y + radius + 1, rows) * width + x] - src[wrap(y - radius, rows) * width + x];
 		}
+	}
+
+	kernel void decayTrailsBlurred(global float* trailMap, global float* blurredTrail, global float* nextTrailMap,
+		global float4* colouredTrail, int mapSize, float simDeltaTime, struct TrailSettings trailSettings)
+	{
+		//same as decayTrails, but with the average from the blur passes instead of the 3x3 box
+		const uint mapPixelIndex = get_global_id(0);
+		if (mapPixelIndex >= mapSize) return;
+
+		float decayed = decayValue(trailMap[mapPixelIndex], blurredTrail[mapPixelIndex], simDeltaTime, trailSettings);
+
+		nextTrailMap[mapPixelIndex] = decayed;
+		colouredTrail[mapPixelIndex] = (float4)(decayed * trailSettings.r, decayed * trailSettings.g, decayed * trailSettings.b, 1.0f);
+	}
+
+	kernel void decayTrailsBandBlurred(global float* trailBand, global float* blurredBand, global float* nextTrailBand,
+		int mapWidth, int bandRows, int margin, float simDeltaTime, struct TrailSettings trailSettings)
+	{
+		const uint bandPixelIndex = get_global_id(0);
+		int y = bandPixelIndex / mapWidth;
+
+		//rows within margin of the band edges weren't reached by every blur pass
+		if (y < margin || y >= bandRows - margin) return;
+
+		nextTrailBand[bandPixelIndex] = decayValue(trailBand[bandPixelIndex], blurredBand[bandPixelIndex], simDeltaTime,
+			trailSettings);
+	}
+
+)+R(
+
+	int trailRow(int row, int slimeRow, int bandStart, int halo, int mapHeight)
+	{
+		//row of the trail buffers holding a row of the map. halo is 0 when the buffers are the whole map
+		if (halo == 0) return wrap(row, mapHeight);
+
+		//a band taller than the map holds some rows twice, so use the copy nearest the slime's starting row.
+		//the halo covers everything a slime can reach, so that copy is never in the margin rows the host throws away
+		int offset = wrap(row - slimeRow + mapHeight / 2, mapHeight) - mapHeight / 2;
+		return halo + slimeRow - bandStart + offset;
+	}
+
+	void updateSlime(uint slimeIndex, global float2* positions, global float2* directions, global float* trailMap,
+		global float* nextTrailMap, global uint* randomSeeds, global float* sensorStrengths, global uint* turnDirections,
+		int mapWidth, int mapHeight, int bandStart, int halo, float simDeltaTime, struct SlimeSettings slimeSettings)
+	{
+		//when running in bands, trailMap and nextTrailMap start halo rows above row bandStart of the full map
+		int slimeRow = convert_int(positions[slimeIndex].y);
 
 		//find which sensor is the strongest
 		float sensorStrength[3] = { 0, 0, 0 };
@@ -128,7 +309,7 @@ return R( // ########################## begin of OpenCL C code #################
 				int dx = di % (1 + 2 * slimeSettings.sensorRadius) - slimeSettings.sensorRadius;
 				int dy = di / (1 + 2 * slimeSettings.sensorRadius) - slimeSettings.sensorRadius;
 				int sx = wrap(sensorPos.x + dx, mapWidth);
-				int sy = wrap(sensorPos.y + dy, mapHeight);
+				int sy = trailRow(sensorPos.y + dy, slimeRow, bandStart, halo, mapHeight);
 
 				sensorStrength[sensorIndex] += trailMap[sy * mapWidth + sx];
 			}
@@ -138,6 +319,10 @@ return R( // ########################## begin of OpenCL C code #################
 		int strongestIndex = sensorStrength[0] > sensorStrength[1] ? 0 : 1;
 		strongestIndex = sensorStrength[strongestIndex] >= sensorStrength[2] ? strongestIndex : 2;
 
+		//keep what was sensed for the statistics kernels, so they don't need to sample the trail map again
+		sensorStrengths[slimeIndex] = sensorStrength[strongestIndex] / sensorSize;
+		turnDirections[slimeIndex] = strongestIndex;
+
 		//turn towards strongest sensor, dont turn if straight ahead
 		if (strongestIndex != 1)
 		{
@@ -162,7 +347,8 @@ return R( // ########################## begin of OpenCL C code #################
 		positions[slimeIndex] = wrapPos(positions[slimeIndex], mapWidth, mapHeight);
 
 		//set trail map strength at position to 1
-		nextTrailMap[(int)positions[slimeIndex].y * mapWidth + (int)positions[slimeIndex].x] = 1.0f;
+		int depositRow = trailRow((int)positions[slimeIndex].y, slimeRow, bandStart, halo, mapHeight);
+		nextTrailMap[depositRow * mapWidth + wrap((int)positions[slimeIndex].x, mapWidth)] = 1.0f;
 
 		if (slimeSettings.depositWidth > 0)
 		{
@@ -172,11 +358,174 @@ return R( // ########################## begin of OpenCL C code #################
 			{
 				float2 depositPos = positions[slimeIndex] + w * perp;
 				depositPos = wrapPos(depositPos, mapWidth, mapHeight);
-				nextTrailMap[(int)depositPos.y * mapWidth + (int)depositPos.x] = 1.0f;
+				depositRow = trailRow((int)depositPos.y, slimeRow, bandStart, halo, mapHeight);
+				nextTrailMap[depositRow * mapWidth + wrap((int)depositPos.x, mapWidth)] = 1.0f;
 			}
 		}
 	}
 
+	kernel void updateSlimes(global float2* positions, global float2* directions, global float* trailMap,
+		global float* nextTrailMap, global uint* randomSeeds, global float* sensorStrengths, global uint* turnDirections,
+		int mapWidth, int mapHeight, float simDeltaTime, struct SlimeSettings slimeSettings, int numSlimes)
+	{
+		const uint slimeIndex = get_global_id(0);
+
+		if (slimeIndex >= numSlimes)
+		{
+			//for some reason, at numslimes less than 128, extra slimes will be created up to 128, and start at 0,0 with
+			//a random positive direction...
+			//they are not present in the host buffer and the host memory object believes there to be the correct
+			//specified number so
+			return;
+		}
+
+		updateSlime(slimeIndex, positions, directions, trailMap, nextTrailMap, randomSeeds, sensorStrengths,
+			turnDirections, mapWidth, mapHeight, 0, 0, simDeltaTime, slimeSettings);
+	}
+
+	kernel void assignBands(global float2* positions, global int* slimeBands, int bandHeight, int numBands,
+		int numSlimes)
+	{
+		const uint slimeIndex = get_global_id(0);
+		if (slimeIndex >= numSlimes) return;
+
+		//slimes belong to the band they start the step in, so each is only moved once per sweep even if it crosses
+		//into the next band
+		slimeBands[slimeIndex] = min(convert_int(positions[slimeIndex].y) / bandHeight, numBands - 1);
+	}
+
+	kernel void updateSlimesBand(global float2* positions, global float2* directions, global float* trailBand,
+		global float* nextTrailBand, global uint* randomSeeds, global float* sensorStrengths, global uint* turnDirections,
+		global int* slimeBands, int band, int bandStart, int halo, int mapWidth, int mapHeight, float simDeltaTime,
+		struct SlimeSettings slimeSettings, int numSlimes)
+	{
+		const uint slimeIndex = get_global_id(0);
+		if (slimeIndex >= numSlimes || slimeBands[slimeIndex] != band) return;
+
+		//the band's halo is wide enough that everything this slime senses or deposits on is inside the band buffers
+		updateSlime(slimeIndex, positions, directions, trailBand, nextTrailBand, randomSeeds, sensorStrengths,
+			turnDirections, mapWidth, mapHeight, bandStart, halo, simDeltaTime, slimeSettings);
+	}
+
+)+R(
+
+	float reduceLocalSum(local float* values, float value)
+	{
+		//tree reduction of one value per work item, all work items in the group get the total
+		const uint localIndex = get_local_id(0);
+		values[localIndex] = value;
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		for (uint stride = get_local_size(0) / 2; stride > 0; stride /= 2)
+		{
+			if (localIndex < stride) values[localIndex] += values[localIndex + stride];
+			barrier(CLK_LOCAL_MEM_FENCE);
+		}
+
+		float sum = values[0];
+		barrier(CLK_LOCAL_MEM_FENCE); //values can be reused straight after returning
+		return sum;
+	}
+
+	kernel void reduceTrailStats(global float* trailMap, global float2* statPartials, global uint* statCounts,
+		int start, int end, float coverageThreshold)
+	{
+		//sums trailMap[start, end) into the partials, so can be run once per band to cover a map out-of-core
+		local float localSums[STATS_GROUP_SIZE];
+		local uint localCoverage;
+
+		const uint localIndex = get_local_id(0);
+		if (localIndex == 0) localCoverage = 0;
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		//launched with a fixed number of work items which each stride over the map, so the number of partial sums
+		//doesn't grow with the map size
+		float mass = 0.0f;
+		uint covered = 0;
+		for (int i = start + get_global_id(0); i < end; i += get_global_size(0))
+		{
+			float value = trailMap[i];
+			mass += value;
+			covered += value > coverageThreshold ? 1 : 0;
+		}
+
+		atomic_add(&localCoverage, covered);
+		float groupMass = reduceLocalSum(localSums, mass);
+
+		if (localIndex == 0)
+		{
+			statPartials[get_group_id(0)].x += groupMass;
+			atomic_add(&statCounts[STAT_COUNT_COVERAGE], localCoverage);
+		}
+	}
+
+	kernel void reduceSlimeStats(global float2* positions, global float* sensorStrengths, global uint* turnDirections,
+		global float2* statPartials, global uint* statCounts, int mapWidth, int mapHeight, int numSlimes)
+	{
+		local float localSums[STATS_GROUP_SIZE];
+		local uint localCounts[STAT_COUNTS_SIZE];
+
+		const uint localIndex = get_local_id(0);
+		for (int i = localIndex; i < STAT_COUNTS_SIZE; i += get_local_size(0)) localCounts[i] = 0;
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		float strength = 0.0f;
+		for (int i = get_global_id(0); i < numSlimes; i += get_global_size(0))
+		{
+			strength += sensorStrengths[i];
+			atomic_inc(&localCounts[STAT_COUNT_TURN + turnDirections[i]]);
+
+			//a tiny negative position can round to exactly mapWidth or mapHeight when wrapped, so clamp into the last bin
+			int binX = min(convert_int(positions[i].x * DENSITY_BINS_X / mapWidth), DENSITY_BINS_X - 1);
+			int binY = min(convert_int(positions[i].y * DENSITY_BINS_Y / mapHeight), DENSITY_BINS_Y - 1);
+			atomic_inc(&localCounts[STAT_COUNT_DENSITY + binY * DENSITY_BINS_X + binX]);
+		}
+
+		float groupStrength = reduceLocalSum(localSums, strength);
+
+		if (localIndex == 0) statPartials[get_group_id(0)].y = groupStrength;
+
+		//one global atomic per bin per group rather than one per slime
+		for (int i = STAT_COUNT_TURN + localIndex; i < STAT_COUNTS_SIZE; i += get_local_size(0))
+		{
+			if (localCounts[i] > 0) atomic_add(&statCounts[i], localCounts[i]);
+		}
+	}
+
+	kernel void finaliseStats(global float2* statPartials, global uint* statCounts, global float* stats, int mapSize,
+		int numSlimes)
+	{
+		//run as a single work group after reduceTrailStats and reduceSlimeStats
+		local float localSums[STATS_GROUP_SIZE];
+
+		const uint localIndex = get_local_id(0);
+		float2 partial = (float2)(0.0f, 0.0f);
+		for (int g = localIndex; g < STATS_NUM_GROUPS; g += get_local_size(0))
+		{
+			partial += statPartials[g];
+			statPartials[g].x = 0.0f; //mass is accumulated like the counts
+		}
+
+		float mass = reduceLocalSum(localSums, partial.x);
+		float strength = reduceLocalSum(localSums, partial.y);
+
+		if (localIndex == 0)
+		{
+			stats[STAT_TRAIL_MASS] = mass;
+			stats[STAT_COVERAGE] = convert_float(statCounts[STAT_COUNT_COVERAGE]) / mapSize;
+			stats[STAT_SENSOR_STRENGTH] = strength / numSlimes;
+		}
+
+		for (int i = STAT_COUNT_TURN + localIndex; i < STAT_COUNTS_SIZE; i += get_local_size(0))
+		{
+			stats[STAT_TURN + i - STAT_COUNT_TURN] = convert_float(statCounts[i]) / numSlimes;
+		}
+
+		//clear the counts ready for the next sample
+		barrier(CLK_GLOBAL_MEM_FENCE);
+		for (int i = localIndex; i < STAT_COUNTS_SIZE; i += get_local_size(0)) statCounts[i] = 0;
+	}
+
 
 
 );
@@ -1,6 +1,13 @@
 
 
 #include "chrono"
+#include "fstream"
+#include "vector"
+
+#include "frame_ring.hpp"
+#include "mapped_file.hpp"
+#include "reference_sim.hpp"
+#include "sim_settings.hpp"
 
 #include "wrapper/opencl.hpp"
 #include "glad/glad.h"
@@ -14,11 +21,48 @@ GLFWwindow* window;
 
 Device gpu;
 Kernel k_decayTrails, k_updateSlimes;
+Kernel k_blurRows, k_blurColumns, k_decayTrailsBlurred;
+Kernel k_reduceTrailStats, k_reduceSlimeStats, k_finaliseStats;
 
 Memory<float> positions, directions;
 Memory<float>* trailMap, *nextTrailMap;
 Memory<float> colouredTrail;
+Memory<float> blurA, blurB; //scratch for the separable diffusion passes
+bool blurBuffersAllocated; //only once a separable diffusion mode is used, as they are several times the map size
 Memory<uint> randomSeeds;
+Memory<float> sensorStrengths;
+Memory<uint> turnDirections;
+Memory<float> statPartials;
+Memory<uint> statCounts;
+Memory<float> stats;
+
+//out-of-core mode keeps the full trail map in host memory (or a memory-mapped file) and streams it through the
+//device one band of rows at a time, so the map size isn't limited by device memory
+struct BandSlot
+{
+	Memory<float> trail, nextTrail;
+	Memory<float> blurA, blurB;
+	int start; //first row of the full map in the band itself
+	int halo; //rows above and below the band also held in the buffers
+	int origin; //row of the full map that the first row of the buffers holds
+	int rows; //number of rows in use, including the halo above and below
+	int margin; //rows at the top and bottom of nextTrail which aren't valid
+} bandSlots[2]; //one band is staged and merged on the host while the other is on the device
+
+Kernel k_assignBands, k_decayTrailsBand, k_updateSlimesBand;
+Kernel k_decayTrailsBandBlurred;
+Memory<int> slimeBands;
+float* hostTrailMap, *hostNextTrailMap;
+MappedFile trailMapFile, nextTrailMapFile;
+std::vector<int> rowWrittenStep; //last step each row of hostNextTrailMap was written, for merging overlapping bands
+std::vector<float> previewTrail;
+int previewWidth, previewHeight;
+const int maxPreviewSize = 2048;
+
+//frames published to shared memory for other local processes, see frame_viewer.cpp
+FrameRing frameRing;
+const char* frameRingName = "/slimecl_frames";
+const uint frameRingSlots = 4;
 
 GLuint trailMapTexture;
 
@@ -27,30 +71,125 @@ int mapHeight;
 int numSlimes;
 float simDeltaTime; //time step to use each frame
 bool simRunning;
+bool fixedSeed;
+int seed;
+bool publishFrames;
+int publishInterval;
+bool outOfCore;
+bool useMappedFile;
+int bandHeight;
+int numBands;
+int bandBufferHalo; //halo the band buffers are currently big enough for
+int simStep;
 
 std::chrono::high_resolution_clock::time_point prevFrameEnd;
 float prevFrameDuration;
+float trailUpdateDuration; //decay and diffusion of the in-core trail map
+
+SlimeSettings slimeSettings;
+TrailSettings trailSettings;
 
-struct SlimeSettings
+struct StatsSettings
 {
-	float slimeSpeed;
-	int sensorRadius;
-	float sensorAngle;
-	float sensorTurnStrength;
-	float directionRandomness;
-	int depositWidth;
-} slimeSettings;
+	int sampleInterval;
+	float coverageThreshold;
+	bool logToCsv;
+} statsSettings;
 
-struct TrailSettings
+struct ValidationSettings
 {
-	float blurRate;
-	float decayRate;
-	float r, g, b;
-} trailSettings;
+	int steps;
+	float trailTolerance; //largest difference in any one trail map pixel before it counts as a divergence
+	float agentTolerance; //distance a slime can be from its reference position before it counts as diverged
+	float directionTolerance; //difference between a slime's unit direction and the reference's before it counts as diverged
+	float meanTrailTolerance; //largest mean trail map difference allowed
+	float massTolerance; //largest relative difference in total trail mass allowed
+	float divergedFraction; //largest fraction of slimes allowed to have diverged
+	bool strict; //fail on the first divergence, rather than only when the statistical bounds are broken
+} validationSettings;
+
+enum StatsLayout
+{
+	//must match the StatsLayout enum in kernel.cpp
+	STATS_GROUP_SIZE = 64,
+	STATS_NUM_GROUPS = 256,
+	DENSITY_BINS_X = 8,
+	DENSITY_BINS_Y = 8,
+	DENSITY_BINS = DENSITY_BINS_X * DENSITY_BINS_Y,
+
+	STAT_COUNT_COVERAGE = 0,
+	STAT_COUNT_TURN = 1,
+	STAT_COUNT_DENSITY = 4,
+	STAT_COUNTS_SIZE = STAT_COUNT_DENSITY + DENSITY_BINS,
+
+	STAT_TRAIL_MASS = 0,
+	STAT_COVERAGE = 1,
+	STAT_SENSOR_STRENGTH = 2,
+	STAT_TURN = 3,
+	STAT_DENSITY = 6,
+	STATS_SIZE = STAT_DENSITY + DENSITY_BINS
+};
+
+const int statsHistoryLength = 256;
+float trailMassHistory[statsHistoryLength];
+float coverageHistory[statsHistoryLength];
+float sensorStrengthHistory[statsHistoryLength];
+int statsHistoryOffset; //index of the oldest sample, so plots scroll
+std::ofstream statsLog;
 
 
 bool initSim();
 bool destroySim();
+bool openFrameRing();
+
+int maxMapSize()
+{
+	//out-of-core is limited by host memory instead, and by the map size fitting in an int
+	return outOfCore ? 40000 : 10000;
+}
+
+int bandMarginFor(int diffusionReach)
+{
+	//rows lost from the top and bottom of a band by the blur, which always needs at least one neighbour
+	return std::max(1, diffusionReach);
+}
+
+int bandHaloFor(int sensorRadius, float moveDistance, int depositWidth, int diffusionReach)
+{
+	//rows above and below a band needed so slimes in it only sense and deposit inside the band buffers, plus
+	//enough that the blur has neighbours for every row that can be deposited on
+	int senseReach = (int)ceilf(3.5f * sensorRadius) + sensorRadius + 1;
+	int depositReach = (int)ceilf(moveDistance) + depositWidth + 1;
+	return std::max(senseReach, depositReach) + bandMarginFor(diffusionReach);
+}
+
+int bandHaloForSettings()
+{
+	return bandHaloFor(slimeSettings.sensorRadius, slimeSettings.slimeSpeed * simDeltaTime, slimeSettings.depositWidth,
+		diffusionReach(trailSettings));
+}
+
+ulong bandBufferSize()
+{
+	//floats in each band buffer, enough for the tallest band with the halo the buffers were allocated for
+	return (ulong)mapWidth * (std::min(bandHeight, mapHeight) + 2 * bandBufferHalo);
+}
+
+void initBlurKernels(int width, int rows)
+{
+	//sized for the largest map or band the passes are run on
+	ulong rowTiles = (ulong)((width + BLUR_ROW_TILE - 1) / BLUR_ROW_TILE) * rows;
+	k_blurRows = Kernel(gpu, rowTiles * BLUR_ROW_GROUP, BLUR_ROW_GROUP, "blurRows");
+	k_blurColumns = Kernel(gpu, (ulong)width * ((rows + BLUR_COLUMN_RUN - 1) / BLUR_COLUMN_RUN), "blurColumns");
+}
+
+void enqueueBoxBlur(Memory<float>& src, Memory<float>& dst, Memory<float>& scratch, int rows, int radius,
+	int wrapRows)
+{
+	//one separable pass from src into dst, which may be the same buffer. rows always wrap
+	k_blurRows.set_parameters(0, src, scratch, mapWidth, rows, radius).enqueue_run();
+	k_blurColumns.set_parameters(0, scratch, dst, mapWidth, rows, radius, wrapRows).enqueue_run();
+}
 
 void drawMenu()
 {
@@ -64,14 +203,36 @@ void drawMenu()
 			if (initSim()) simRunning = true;
 		}
 
+		ImGui::Checkbox("Fixed Seed", &fixedSeed);
+		if (fixedSeed)
+		{
+			ImGui::InputInt("Seed", &seed);
+		}
+
+		if (ImGui::Checkbox("Out-of-Core Trail Map", &outOfCore))
+		{
+			mapWidth = std::min(mapWidth, maxMapSize());
+			mapHeight = std::min(mapHeight, maxMapSize());
+		}
+
+		if (outOfCore)
+		{
+			if (ImGui::InputInt("Band Height", &bandHeight))
+			{
+				bandHeight = std::min(std::max(bandHeight, 16), 8192);
+			}
+
+			ImGui::Checkbox("Use Memory-Mapped File", &useMappedFile);
+		}
+
 		if (ImGui::InputInt("Map Width", &mapWidth))
 		{
-			mapWidth = std::min(std::max(mapWidth, 10), 10000);
+			mapWidth = std::min(std::max(mapWidth, 10), maxMapSize());
 		}
 
 		if (ImGui::InputInt("Map Height", &mapHeight))
 		{
-			mapHeight = std::min(std::max(mapHeight, 10), 10000);
+			mapHeight = std::min(std::max(mapHeight, 10), maxMapSize());
 		}
 
 		if (ImGui::InputInt("Number of Slimes", &numSlimes))
@@ -89,6 +250,27 @@ void drawMenu()
 		ImGui::LabelText("Map Width", std::to_string(mapWidth).c_str());
 		ImGui::LabelText("Map Height", std::to_string(mapHeight).c_str());
 		ImGui::LabelText("NUmber of Slimes", std::to_string(numSlimes).c_str());
+
+		if (fixedSeed)
+		{
+			ImGui::LabelText("Seed", std::to_string(seed).c_str());
+		}
+
+		if (outOfCore)
+		{
+			ImGui::LabelText("Bands", std::to_string(numBands).c_str());
+		}
+	}
+
+	if (ImGui::Checkbox("Publish Frames", &publishFrames) && simRunning)
+	{
+		if (publishFrames) publishFrames = openFrameRing();
+		else frameRing.close();
+	}
+	if (publishFrames)
+	{
+		//in-core frames need a readback of the whole trail map, so publishing less often keeps that off most steps
+		ImGui::SliderInt("Publish Interval", &publishInterval, 1, 100, "%d steps", ImGuiSliderFlags_AlwaysClamp);
 	}
 
 	ImGui::DragFloat("Sim Delta Time", &simDeltaTime, 0.001f, 0.001f, 10.0f, "%.3f s", ImGuiSliderFlags_AlwaysClamp);
@@ -101,8 +283,36 @@ void drawMenu()
 	ImGui::SliderFloat("Direction Randomness", &slimeSettings.directionRandomness, 0.0f, 1.0f, "%.2f", ImGuiSliderFlags_AlwaysClamp);
 	ImGui::SliderInt("Deposit Width", &slimeSettings.depositWidth, 0, 5, "%d", ImGuiSliderFlags_AlwaysClamp);
 
+	ImGui::SeparatorText("Statistics Settings");
+	ImGui::SliderInt("Sample Interval", &statsSettings.sampleInterval, 1, 100, "%d steps", ImGuiSliderFlags_AlwaysClamp);
+	ImGui::SliderFloat("Coverage Threshold", &statsSettings.coverageThreshold, 0.0f, 1.0f, "%.3f", ImGuiSliderFlags_AlwaysClamp);
+	if (ImGui::Checkbox("Log to CSV", &statsSettings.logToCsv))
+	{
+		if (statsSettings.logToCsv)
+		{
+			statsLog.open("stats.csv");
+			statsLog << "step,trailMass,coverage,sensorStrength,turnLeft,turnStraight,turnRight";
+			for (int i = 0; i < DENSITY_BINS; i++) statsLog << ",density" << i;
+			statsLog << std::endl;
+		}
+		else
+		{
+			statsLog.close();
+		}
+	}
+
 	ImGui::SeparatorText("Trail Settings");
 	ImGui::SliderFloat("Blur Rate", &trailSettings.blurRate, 0.0f, 1.0f, "%.2f", ImGuiSliderFlags_AlwaysClamp);
+	const char* diffusionModes[] = { "3x3 Box", "Box", "Gaussian" };
+	ImGui::Combo("Diffusion", &trailSettings.diffusionMode, diffusionModes, 3);
+	if (trailSettings.diffusionMode == DIFFUSION_BOX)
+	{
+		ImGui::SliderInt("Diffusion Radius", &trailSettings.diffusionRadius, 1, maxDiffusionRadius, "%d pixels", ImGuiSliderFlags_AlwaysClamp);
+	}
+	else if (trailSettings.diffusionMode == DIFFUSION_GAUSSIAN)
+	{
+		ImGui::SliderFloat("Diffusion Sigma", &trailSettings.diffusionSigma, 0.5f, maxDiffusionSigma, "%.1f pixels", ImGuiSliderFlags_AlwaysClamp);
+	}
 	ImGui::SliderFloat("Decay Rate", &trailSettings.decayRate, 0.0f, 0.2f, "%.3f", ImGuiSliderFlags_AlwaysClamp);
 	float editColour[3] = { trailSettings.r, trailSettings.g, trailSettings.b };
 	if (ImGui::ColorEdit3("Trail Colour", editColour))
@@ -119,6 +329,7 @@ void drawTrails()
 {	
 	ImGui::Begin("Trail Map");
 	ImGui::LabelText("", ("Frame time: " + std::to_string(prevFrameDuration) + "ms").c_str());
+	if (!outOfCore) ImGui::LabelText("", ("Trail update: " + std::to_string(trailUpdateDuration) + "ms").c_str());
 	ImGui::BeginChild("trailimage");
 
 	//make the image sit nicely in the window with the correct aspect ratio
@@ -141,6 +352,69 @@ void drawTrails()
 	ImGui::End();
 }
 
+void drawStats()
+{
+	ImGui::Begin("Statistics");
+
+	ImVec2 plotSize = { 0.0f, 120.0f };
+	int latest = (statsHistoryOffset + statsHistoryLength - 1) % statsHistoryLength;
+
+	ImGui::PlotLines("Trail Mass", trailMassHistory, statsHistoryLength, statsHistoryOffset,
+		std::to_string(trailMassHistory[latest]).c_str(), FLT_MAX, FLT_MAX, plotSize);
+	ImGui::PlotLines("Coverage", coverageHistory, statsHistoryLength, statsHistoryOffset,
+		std::to_string(coverageHistory[latest]).c_str(), 0.0f, 1.0f, plotSize);
+	ImGui::PlotLines("Sensor Strength", sensorStrengthHistory, statsHistoryLength, statsHistoryOffset,
+		std::to_string(sensorStrengthHistory[latest]).c_str(), 0.0f, FLT_MAX, plotSize);
+
+	//left, straight, right
+	ImGui::PlotHistogram("Turn Direction", &stats[STAT_TURN], 3, 0, NULL, 0.0f, 1.0f, plotSize);
+
+	//each row of the map is laid out one after another
+	ImGui::PlotHistogram("Slime Density", &stats[STAT_DENSITY], DENSITY_BINS, 0, NULL, 0.0f, FLT_MAX, plotSize);
+
+	ImGui::End();
+}
+
+void setDefaults()
+{
+	//set default parameters
+	//want to remember parameters between simulation resets, so only init once
+	mapWidth = 1024;
+	mapHeight = 1024;
+	numSlimes = 1000;
+	simDeltaTime = 0.1f; //time step to use each frame
+	simRunning = false;
+	fixedSeed = false; //seed from the clock so each run is different
+	publishFrames = false; //don't create the shared memory frame ring
+	publishInterval = 1; //number of sim steps between each published frame
+	seed = 1;
+	outOfCore = false; //keep the whole trail map on the device
+	useMappedFile = false; //out-of-core trail map is in RAM rather than a file
+	bandHeight = 1024; //rows of the trail map processed on the device at once when out-of-core
+
+	slimeSettings = defaultSlimeSettings();
+	trailSettings = defaultTrailSettings();
+
+	statsSettings.sampleInterval = 10; //number of sim steps between each statistics sample
+	statsSettings.coverageThreshold = 0.01f; //trail strength above which a pixel counts as covered
+	statsSettings.logToCsv = false;
+
+	validationSettings.steps = 100;
+	validationSettings.trailTolerance = 1e-3f;
+	validationSettings.agentTolerance = 0.01f;
+	validationSettings.directionTolerance = 1e-3f;
+	validationSettings.meanTrailTolerance = 1e-3f;
+	validationSettings.massTolerance = 0.01f;
+	validationSettings.divergedFraction = 0.05f;
+	validationSettings.strict = false;
+}
+
+void initDevice()
+{
+	//gpu = Device(select_device_with_most_flops());
+	gpu = Device(select_device_with_id(1));
+}
+
 bool initOnce()
 {
 	//set up GLFW and glad
@@ -174,30 +448,8 @@ bool initOnce()
 	ImGui::GetStyle().ScaleAllSizes(2.0f); //make things more readable at high screen res
 
 
-	//set default parameters
-	//want to remember parameters between simulation resets, so only init once
-	mapWidth = 1024;
-	mapHeight = 1024;
-	numSlimes = 1000;
-	simDeltaTime = 0.1f; //time step to use each frame
-	simRunning = false;
-
-	slimeSettings.slimeSpeed = 5.0f; //number of pixels per 1 second of sim time
-	slimeSettings.sensorRadius = 2; //size in pixels of sensor box width in each direction from centre (e.g. sensorRadius = 2, box is 5x5)
-	slimeSettings.sensorAngle = pi * 0.25f; //angle from direction of slime to left/right sensors
-	slimeSettings.sensorTurnStrength = 0.3f; //how strongly the slime turns towards the strongest sensor
-	slimeSettings.directionRandomness = 0.1f; //how much randomness changes the slime's direction
-	slimeSettings.depositWidth = 0; //how many pixels each side of the slime to leave a trail on
-
-	trailSettings.blurRate = 0.2f;
-	trailSettings.decayRate = 0.005f;
-	trailSettings.r = 0.2f;
-	trailSettings.g = 1.0f;
-	trailSettings.b = 0.6f;
-
-
-	//gpu = Device(select_device_with_most_flops());
-	gpu = Device(select_device_with_id(1));
+	setDefaults();
+	initDevice();
 
 	//set up texture for displaying trailMap
 	glGenTextures(1, &trailMapTexture);
@@ -208,38 +460,158 @@ bool initOnce()
 	return true;
 }
 
+void allocateBlurBuffers()
+{
+	if (blurBuffersAllocated) return;
+
+	if (outOfCore)
+	{
+		ulong maxBandSize = bandBufferSize();
+		for (BandSlot& slot : bandSlots)
+		{
+			slot.blurA = Memory<float>(gpu, maxBandSize);
+			slot.blurB = Memory<float>(gpu, maxBandSize);
+		}
+	}
+	else
+	{
+		ulong mapSize = (ulong)mapWidth * mapHeight;
+		blurA = Memory<float>(gpu, mapSize);
+		blurB = Memory<float>(gpu, mapSize);
+	}
+
+	blurBuffersAllocated = true;
+}
+
+void freeBlurBuffers()
+{
+	blurA = Memory<float>();
+	blurB = Memory<float>();
+	for (BandSlot& slot : bandSlots)
+	{
+		slot.blurA = Memory<float>();
+		slot.blurB = Memory<float>();
+	}
+
+	blurBuffersAllocated = false;
+}
+
+void allocateBandBuffers(int halo)
+{
+	//sized for the halo the current settings need rather than the largest the sliders allow, which would be hundreds
+	//of rows above and below every band
+	bandBufferHalo = halo;
+	ulong maxBandSize = bandBufferSize();
+	for (BandSlot& slot : bandSlots)
+	{
+		slot.trail = Memory<float>(gpu, maxBandSize);
+		slot.nextTrail = Memory<float>(gpu, maxBandSize);
+	}
+
+	k_decayTrailsBand = Kernel(gpu, maxBandSize, "decayTrailsBand");
+	initBlurKernels(mapWidth, maxBandSize / mapWidth);
+	k_decayTrailsBandBlurred = Kernel(gpu, maxBandSize, "decayTrailsBandBlurred");
+
+	//the blur scratch is band sized too, so is allocated again at the new size when next used
+	freeBlurBuffers();
+}
+
+bool initOutOfCore()
+{
+	size_t mapSize = (size_t)mapWidth * mapHeight;
+	if (useMappedFile)
+	{
+		if (!trailMapFile.open("trailMap.bin", mapSize) || !nextTrailMapFile.open("nextTrailMap.bin", mapSize))
+		{
+			std::cerr << "Failed to map trail map files" << std::endl;
+			trailMapFile.close();
+			return false;
+		}
+
+		hostTrailMap = trailMapFile.data;
+		hostNextTrailMap = nextTrailMapFile.data;
+	}
+	else
+	{
+		hostTrailMap = new float[mapSize];
+		hostNextTrailMap = new float[mapSize];
+		std::fill_n(hostTrailMap, mapSize, 0.0f);
+		std::fill_n(hostNextTrailMap, mapSize, 0.0f);
+	}
+
+	numBands = (mapHeight + bandHeight - 1) / bandHeight;
+	rowWrittenStep.assign(mapHeight, -1);
+
+	allocateBandBuffers(bandHaloForSettings());
+
+	slimeBands = Memory<int>(gpu, numSlimes);
+	k_assignBands = Kernel(gpu, numSlimes, "assignBands");
+	k_updateSlimesBand = Kernel(gpu, numSlimes, "updateSlimesBand");
+
+	previewWidth = std::min(mapWidth, maxPreviewSize);
+	previewHeight = std::min(mapHeight, maxPreviewSize);
+	previewTrail.assign((size_t)previewWidth * previewHeight * 4, 1.0f);
+
+	return true;
+}
+
 bool initSim()
 {
+	//with a fixed seed the initial slimes, and so the whole run, are the same every time
+	if (fixedSeed) srand(seed);
+
 	int mapSize = mapWidth * mapHeight;
 	positions = Memory<float>(gpu, numSlimes, 2);
 	directions = Memory<float>(gpu, numSlimes, 2);
-	trailMap = new Memory<float>(gpu, mapSize);
-	nextTrailMap = new Memory<float>(gpu, mapSize);
-	colouredTrail = Memory<float>(gpu, mapSize, 4);
 	randomSeeds = Memory<uint>(gpu, numSlimes);
+	sensorStrengths = Memory<float>(gpu, numSlimes);
+	turnDirections = Memory<uint>(gpu, numSlimes);
+	statPartials = Memory<float>(gpu, STATS_NUM_GROUPS, 2);
+	statCounts = Memory<uint>(gpu, STAT_COUNTS_SIZE);
+	stats = Memory<float>(gpu, STATS_SIZE);
 
-	k_decayTrails = Kernel(gpu, mapSize, "decayTrails");
-	k_updateSlimes = Kernel(gpu, numSlimes, "updateSlimes");
-
-	for (int i = 0; i < mapSize; i++)
+	if (outOfCore)
+	{
+		if (!initOutOfCore()) return false;
+	}
+	else
 	{
-		(*trailMap)[i] = 0.0f;
-		(*nextTrailMap)[i] = 0.0f;
+		trailMap = new Memory<float>(gpu, mapSize);
+		nextTrailMap = new Memory<float>(gpu, mapSize);
+		colouredTrail = Memory<float>(gpu, mapSize, 4);
+
+		k_decayTrails = Kernel(gpu, mapSize, "decayTrails");
+		k_updateSlimes = Kernel(gpu, numSlimes, "updateSlimes");
+
+		initBlurKernels(mapWidth, mapHeight);
+		k_decayTrailsBlurred = Kernel(gpu, mapSize, "decayTrailsBlurred");
+
+		for (int i = 0; i < mapSize; i++)
+		{
+			(*trailMap)[i] = 0.0f;
+			(*nextTrailMap)[i] = 0.0f;
+		}
+
+		(*trailMap).write_to_device();
+		(*nextTrailMap).write_to_device();
 	}
 
-	(*trailMap).write_to_device();
-	(*nextTrailMap).write_to_device();
+	//statistics kernels run a fixed number of work items regardless of map size or number of slimes
+	k_reduceTrailStats = Kernel(gpu, STATS_NUM_GROUPS * STATS_GROUP_SIZE, STATS_GROUP_SIZE, "reduceTrailStats");
+	k_reduceSlimeStats = Kernel(gpu, STATS_NUM_GROUPS * STATS_GROUP_SIZE, STATS_GROUP_SIZE, "reduceSlimeStats");
+	k_finaliseStats = Kernel(gpu, STATS_GROUP_SIZE, STATS_GROUP_SIZE, "finaliseStats");
 
+	//positions and directions are interleaved x, y per slime, as the kernels read them as float2
 	for (int i = 0; i < numSlimes; i++)
 	{
-		positions.x[i] = rand() % mapWidth;
-		positions.y[i] = rand() % mapHeight;
+		positions[i * 2] = rand() % mapWidth;
+		positions[i * 2 + 1] = rand() % mapHeight;
 
 		float dx = (float)rand() / RAND_MAX - 0.5f;
 		float dy = (float)rand() / RAND_MAX - 0.5f;
 		float l = sqrtf(dx * dx + dy * dy);
-		directions.x[i] = dx / l;
-		directions.y[i] = dy / l;
+		directions[i * 2] = dx / l;
+		directions[i * 2 + 1] = dy / l;
 
 		randomSeeds[i] = rand();
 	}
@@ -248,14 +620,332 @@ bool initSim()
 	directions.write_to_device();
 	randomSeeds.write_to_device();
 
+	//counts and mass are accumulated, finaliseStats clears them after each sample
+	for (int i = 0; i < STAT_COUNTS_SIZE; i++) statCounts[i] = 0;
+	statCounts.write_to_device();
+	for (int i = 0; i < STATS_NUM_GROUPS * 2; i++) statPartials[i] = 0.0f;
+	statPartials.write_to_device();
+
+	for (int i = 0; i < statsHistoryLength; i++)
+	{
+		trailMassHistory[i] = 0.0f;
+		coverageHistory[i] = 0.0f;
+		sensorStrengthHistory[i] = 0.0f;
+	}
+	for (int i = 0; i < STATS_SIZE; i++) stats[i] = 0.0f;
+	statsHistoryOffset = 0;
+	simStep = 0;
+
+
+	if (publishFrames) publishFrames = openFrameRing();
 
 	//frame timing
 	prevFrameEnd = std::chrono::high_resolution_clock::now();
 	prevFrameDuration = 0.0f;
+	trailUpdateDuration = 0.0f;
+
+	return true;
+}
+
+void enqueueSlimeStats()
+{
+	k_reduceSlimeStats.set_parameters(0, positions, sensorStrengths, turnDirections, statPartials, statCounts, mapWidth,
+		mapHeight, numSlimes).enqueue_run();
+}
+
+void finishStats(int step)
+{
+	//reduce on the device so only STATS_SIZE floats need reading back, rather than the whole trail map and slimes
+	k_finaliseStats.set_parameters(0, statPartials, statCounts, stats, mapWidth * mapHeight, numSlimes).run();
+	stats.read_from_device();
+
+	trailMassHistory[statsHistoryOffset] = stats[STAT_TRAIL_MASS];
+	coverageHistory[statsHistoryOffset] = stats[STAT_COVERAGE];
+	sensorStrengthHistory[statsHistoryOffset] = stats[STAT_SENSOR_STRENGTH];
+	statsHistoryOffset = (statsHistoryOffset + 1) % statsHistoryLength;
+
+	if (statsSettings.logToCsv)
+	{
+		statsLog << step;
+		for (int i = 0; i < STATS_SIZE; i++) statsLog << "," << stats[i];
+		statsLog << "\n";
+	}
+}
+
+void sampleStats()
+{
+	k_reduceTrailStats.set_parameters(0, *trailMap, statPartials, statCounts, 0, mapWidth * mapHeight,
+		statsSettings.coverageThreshold).enqueue_run();
+	enqueueSlimeStats();
+	finishStats(simStep);
+}
+
+bool stageBand(int band, int halo, int margin)
+{
+	//copy the band's rows, and halo rows either side, from the host trail map into the slot's host buffer
+	BandSlot& slot = bandSlots[band % 2];
+	int bandStart = band * bandHeight;
+	int rows = std::min(bandHeight, mapHeight - bandStart) + 2 * halo;
+	if ((ulong)rows * mapWidth > slot.trail.length())
+	{
+		std::cerr << "Band " << band << " with a halo of " << halo << " rows does not fit in band buffers sized for "
+			<< bandBufferHalo << std::endl;
+		return false;
+	}
+
+	slot.start = bandStart;
+	slot.halo = halo;
+	slot.rows = rows;
+	slot.origin = ((bandStart - halo) % mapHeight + mapHeight) % mapHeight;
+	slot.margin = margin;
+
+	for (int r = 0; r < slot.rows; r++)
+	{
+		int row = (slot.origin + r) % mapHeight;
+		std::copy_n(hostTrailMap + (size_t)row * mapWidth, mapWidth, slot.trail.data() + (size_t)r * mapWidth);
+	}
 
 	return true;
 }
 
+void enqueueBand(int band, bool sample)
+{
+	//doesn't wait for the device, the slot's buffers are left alone until the queue has finished with them
+	BandSlot& slot = bandSlots[band % 2];
+	ulong bandSize = (ulong)slot.rows * mapWidth;
+
+	slot.trail.enqueue_write_to_device(0ull, bandSize);
+
+	if (sample)
+	{
+		//only the band's own rows, the halo rows are counted by the bands they belong to
+		int bandRows = slot.rows - 2 * slot.halo;
+		k_reduceTrailStats.set_parameters(0, slot.trail, statPartials, statCounts, slot.halo * mapWidth,
+			(slot.halo + bandRows) * mapWidth, statsSettings.coverageThreshold).enqueue_run();
+	}
+
+	int radii[3];
+	int passes = diffusionPassRadii(trailSettings, radii);
+	if (passes == 0)
+	{
+		k_decayTrailsBand.set_parameters(0, slot.trail, slot.nextTrail, mapWidth, slot.rows, simDeltaTime,
+			trailSettings).enqueue_run();
+	}
+	else
+	{
+		//columns don't wrap within a band, each pass loses its radius from the top and bottom rows
+		Memory<float>* src = &slot.trail;
+		for (int pass = 0; pass < passes; pass++)
+		{
+			enqueueBoxBlur(*src, slot.blurB, slot.blurA, slot.rows, radii[pass], 0);
+			src = &slot.blurB;
+		}
+
+		k_decayTrailsBandBlurred.set_parameters(0, slot.trail, slot.blurB, slot.nextTrail, mapWidth, slot.rows,
+			slot.margin, simDeltaTime, trailSettings).enqueue_run();
+	}
+
+	k_updateSlimesBand.set_parameters(0, positions, directions, slot.trail, slot.nextTrail, randomSeeds,
+		sensorStrengths, turnDirections, slimeBands, band, slot.start, slot.halo, mapWidth, mapHeight, simDeltaTime,
+		slimeSettings, numSlimes).enqueue_run();
+	slot.nextTrail.enqueue_read_from_device(0ull, bandSize);
+}
+
+void mergeBand(int band)
+{
+	//halo rows are also computed by the neighbouring band, or twice by the same band when it is taller than the map,
+	//and either may have had slimes deposit on them.
+	//apart from deposits both bands compute the same value, and a deposit sets the trail to its maximum of 1, so the
+	//max of the two is the same as if the whole map had been done at once
+	BandSlot& slot = bandSlots[band % 2];
+
+	//rows within the margin didn't have all their blur neighbours so are not valid
+	for (int r = slot.margin; r < slot.rows - slot.margin; r++)
+	{
+		int row = (slot.origin + r) % mapHeight;
+		float* dst = hostNextTrailMap + (size_t)row * mapWidth;
+		const float* src = slot.nextTrail.data() + (size_t)r * mapWidth;
+
+		if (rowWrittenStep[row] == simStep)
+		{
+			for (int x = 0; x < mapWidth; x++) dst[x] = std::max(dst[x], src[x]);
+		}
+		else
+		{
+			std::copy_n(src, mapWidth, dst);
+			rowWrittenStep[row] = simStep;
+		}
+	}
+}
+
+void stepOutOfCore()
+{
+	int margin = bandMarginFor(diffusionReach(trailSettings));
+	int halo = bandHaloForSettings();
+
+	//settings can change between steps, so grow the band buffers when they need a wider halo, and shrink them again
+	//once they need much less. the previous step has finished with them by now
+	if (halo > bandBufferHalo || halo < bandBufferHalo / 2) allocateBandBuffers(halo);
+
+	if (trailSettings.diffusionMode != DIFFUSION_3X3) allocateBlurBuffers();
+
+	//the full trail map is only ever on the device a band at a time, so statistics are reduced from the bands as they
+	//are uploaded at the start of the next step, together with the slimes before they move again
+	bool sample = simStep > 0 && (simStep - 1) % statsSettings.sampleInterval == 0;
+	if (sample) enqueueSlimeStats();
+
+	k_assignBands.set_parameters(0, positions, slimeBands, bandHeight, numBands, numSlimes).enqueue_run();
+
+	//pipelined sweep: while the device works on one band, the host stages the next and merges the previous
+	for (int band = 0; band <= numBands; band++)
+	{
+		if (band < numBands && !stageBand(band, halo, margin))
+		{
+			//let the band in flight finish so its rows aren't lost, and leave the rest of the map as it was
+			gpu.finish_queue();
+			if (band > 0) mergeBand(band - 1);
+			return;
+		}
+		gpu.finish_queue();
+		if (band < numBands) enqueueBand(band, sample);
+		if (band > 0) mergeBand(band - 1);
+	}
+
+	if (sample) finishStats(simStep - 1);
+
+	std::swap(hostTrailMap, hostNextTrailMap);
+}
+
+float samplePreview(int px, int py)
+{
+	//nearest pixel of the full map to a pixel of the preview
+	return hostTrailMap[(size_t)(py * mapHeight / previewHeight) * mapWidth + px * mapWidth / previewWidth];
+}
+
+void updatePreview()
+{
+	//the full map is too big to colour and upload every frame, so show a nearest pixel downsample of it
+	for (int py = 0; py < previewHeight; py++)
+	{
+		for (int px = 0; px < previewWidth; px++)
+		{
+			float value = samplePreview(px, py);
+			float* pixel = &previewTrail[((size_t)py * previewWidth + px) * 4];
+			pixel[0] = value * trailSettings.r;
+			pixel[1] = value * trailSettings.g;
+			pixel[2] = value * trailSettings.b;
+		}
+	}
+}
+
+void stepSim()
+{
+	if (outOfCore)
+	{
+		stepOutOfCore();
+	}
+	else
+	{
+		std::chrono::high_resolution_clock::time_point trailUpdateStart = std::chrono::high_resolution_clock::now();
+
+		int radii[3];
+		int passes = diffusionPassRadii(trailSettings, radii);
+		if (passes == 0)
+		{
+			k_decayTrails.set_parameters(0, *trailMap, *nextTrailMap, colouredTrail, mapWidth, mapHeight, simDeltaTime,
+				trailSettings).run();
+		}
+		else
+		{
+			//separable box passes of two kernels each, so wide diffusion costs about the same per pixel as narrow
+			allocateBlurBuffers();
+			Memory<float>* src = trailMap;
+			for (int pass = 0; pass < passes; pass++)
+			{
+				enqueueBoxBlur(*src, blurB, blurA, mapHeight, radii[pass], 1);
+				src = &blurB;
+			}
+
+			k_decayTrailsBlurred.set_parameters(0, *trailMap, blurB, *nextTrailMap, colouredTrail, mapWidth * mapHeight,
+				simDeltaTime, trailSettings).run();
+		}
+
+		//run waits for the device, so this is how long the trail update took on it
+		trailUpdateDuration = (std::chrono::high_resolution_clock::now() - trailUpdateStart).count() / 1e6;
+
+		k_updateSlimes.set_parameters(0, positions, directions, *trailMap, *nextTrailMap, randomSeeds, sensorStrengths,
+			turnDirections, mapWidth, mapHeight, simDeltaTime, slimeSettings, numSlimes).run();
+
+		std::swap(trailMap, nextTrailMap);
+
+		if (simStep % statsSettings.sampleInterval == 0) sampleStats();
+	}
+
+	simStep++;
+}
+
+bool openFrameRing()
+{
+	//out-of-core maps are published at preview size, the same as they are displayed
+	ulong frameBytes = outOfCore ? (ulong)previewWidth * previewHeight * sizeof(float) :
+		(ulong)mapWidth * mapHeight * sizeof(float);
+
+	if (!frameRing.create(frameRingName, frameRingSlots, frameBytes))
+	{
+		std::cerr << "Failed to create shared memory frame ring " << frameRingName << " of "
+			<< frameRingSlots * frameBytes / (1024 * 1024) << " MB" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+uint64_t settingsHash()
+{
+	//FNV-1a of everything that changes how the sim behaves, so consumers can tell when it was changed
+	uint64_t hash = 14695981039346656037ull;
+	auto hashBytes = [&hash](const void* data, size_t size)
+	{
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= ((const unsigned char*)data)[i];
+			hash *= 1099511628211ull;
+		}
+	};
+
+	hashBytes(&slimeSettings, sizeof(slimeSettings));
+	hashBytes(&trailSettings, sizeof(trailSettings));
+	hashBytes(&simDeltaTime, sizeof(simDeltaTime));
+	return hash;
+}
+
+void publishFrame()
+{
+	//written straight into the shared memory slot, readers then use it from there without copying
+	if (outOfCore)
+	{
+		float* frame = (float*)frameRing.beginFrame(simStep, previewWidth, previewHeight, mapWidth, mapHeight,
+			FRAME_FORMAT_R32F, settingsHash(), (ulong)previewWidth * previewHeight * sizeof(float));
+
+		for (int py = 0; py < previewHeight; py++)
+		{
+			for (int px = 0; px < previewWidth; px++) frame[(size_t)py * previewWidth + px] = samplePreview(px, py);
+		}
+	}
+	else
+	{
+		//read back before starting the frame, readers see the slot as being written until endFrame
+		size_t mapSize = (size_t)mapWidth * mapHeight;
+		trailMap->read_from_device();
+
+		float* frame = (float*)frameRing.beginFrame(simStep, mapWidth, mapHeight, mapWidth, mapHeight,
+			FRAME_FORMAT_R32F, settingsHash(), mapSize * sizeof(float));
+		std::copy_n(trailMap->data(), mapSize, frame);
+	}
+
+	frameRing.endFrame();
+}
+
 bool update()
 {
 	ImGui_ImplOpenGL3_NewFrame();
@@ -264,19 +954,25 @@ bool update()
 
 	if (simRunning)
 	{
-		k_decayTrails.set_parameters(0, *trailMap, *nextTrailMap, colouredTrail, mapWidth, mapHeight, simDeltaTime,
-			trailSettings).run();
+		stepSim();
 
-		k_updateSlimes.set_parameters(0, positions, directions, *trailMap, *nextTrailMap, randomSeeds, mapWidth,
-			mapHeight, simDeltaTime, slimeSettings, numSlimes).run();
+		if (frameRing.isOpen() && simStep % publishInterval == 0) publishFrame();
 
-		std::swap(trailMap, nextTrailMap);
-
-		//copy updated trail back from device (to then send back to the device in the texture...)
-		colouredTrail.read_from_device();
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, mapWidth, mapHeight, 0, GL_RGBA, GL_FLOAT, colouredTrail.data());
+		if (outOfCore)
+		{
+			updatePreview();
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, previewWidth, previewHeight, 0, GL_RGBA, GL_FLOAT,
+				previewTrail.data());
+		}
+		else
+		{
+			//copy updated trail back from device (to then send back to the device in the texture...)
+			colouredTrail.read_from_device();
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, mapWidth, mapHeight, 0, GL_RGBA, GL_FLOAT, colouredTrail.data());
+		}
 		
 		drawTrails();
+		drawStats();
 	}
 	
 	drawMenu();
@@ -294,8 +990,30 @@ bool update()
 bool destroySim()
 {
 	simRunning = false;
-	delete trailMap;
-	delete nextTrailMap;
+
+	if (outOfCore)
+	{
+		if (useMappedFile)
+		{
+			trailMapFile.close();
+			nextTrailMapFile.close();
+		}
+		else
+		{
+			delete[] hostTrailMap;
+			delete[] hostNextTrailMap;
+		}
+	}
+	else
+	{
+		delete trailMap;
+		delete nextTrailMap;
+	}
+
+	freeBlurBuffers();
+
+	if (statsSettings.logToCsv) statsLog.flush();
+	frameRing.close();
 
 	return true;
 }
@@ -303,6 +1021,7 @@ bool destroySim()
 bool destroy()
 {
 	if (simRunning) destroySim();
+	if (statsLog.is_open()) statsLog.close();
 
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
@@ -313,8 +1032,223 @@ bool destroy()
 	return true;
 }
 
-int main()
+bool parseValidationArgs(int argc, char** argv)
+{
+	for (int i = 2; i < argc; i++)
+	{
+		std::string arg = argv[i];
+
+		//flags without a value
+		if (arg == "--out-of-core") { outOfCore = true; continue; }
+		if (arg == "--mapped-file") { useMappedFile = true; continue; }
+		if (arg == "--strict") { validationSettings.strict = true; continue; }
+
+		if (i + 1 >= argc)
+		{
+			std::cerr << "Missing value for " << arg << std::endl;
+			return false;
+		}
+
+		std::string value = argv[++i];
+		if (arg == "--steps") validationSettings.steps = std::stoi(value);
+		else if (arg == "--seed") seed = std::stoi(value);
+		else if (arg == "--width") mapWidth = std::stoi(value);
+		else if (arg == "--height") mapHeight = std::stoi(value);
+		else if (arg == "--slimes") numSlimes = std::stoi(value);
+		else if (arg == "--band-height") bandHeight = std::stoi(value);
+		else if (arg == "--delta-time") simDeltaTime = std::stof(value);
+		else if (arg == "--deposit-width") slimeSettings.depositWidth = std::stoi(value);
+		else if (arg == "--diffusion-mode") trailSettings.diffusionMode = std::stoi(value);
+		else if (arg == "--diffusion-radius") trailSettings.diffusionRadius = std::stoi(value);
+		else if (arg == "--diffusion-sigma") trailSettings.diffusionSigma = std::stof(value);
+		else if (arg == "--trail-tolerance") validationSettings.trailTolerance = std::stof(value);
+		else if (arg == "--agent-tolerance") validationSettings.agentTolerance = std::stof(value);
+		else if (arg == "--direction-tolerance") validationSettings.directionTolerance = std::stof(value);
+		else if (arg == "--mean-trail-tolerance") validationSettings.meanTrailTolerance = std::stof(value);
+		else if (arg == "--mass-tolerance") validationSettings.massTolerance = std::stof(value);
+		else if (arg == "--diverged-fraction") validationSettings.divergedFraction = std::stof(value);
+		else
+		{
+			std::cerr << "Unknown argument " << arg << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int runValidation(int argc, char** argv)
 {
+	//headless run stepping the device engine and ReferenceSim side by side from the same seeded start, comparing
+	//trail maps and slimes after every step. returns 0 if the device engine stays within the tolerances
+	setDefaults();
+	fixedSeed = true;
+	if (!parseValidationArgs(argc, argv)) return -1;
+
+	mapWidth = std::min(std::max(mapWidth, 10), maxMapSize());
+	mapHeight = std::min(std::max(mapHeight, 10), maxMapSize());
+	numSlimes = std::min(std::max(numSlimes, 1), (int)1e6);
+	simDeltaTime = std::min(std::max(simDeltaTime, 0.001f), 10.0f);
+	slimeSettings.depositWidth = std::min(std::max(slimeSettings.depositWidth, 0), 5);
+	bandHeight = std::min(std::max(bandHeight, 16), 8192);
+	trailSettings.diffusionMode = std::min(std::max(trailSettings.diffusionMode, (int)DIFFUSION_3X3), (int)DIFFUSION_GAUSSIAN);
+	trailSettings.diffusionRadius = std::min(std::max(trailSettings.diffusionRadius, 1), maxDiffusionRadius);
+	trailSettings.diffusionSigma = std::min(std::max(trailSettings.diffusionSigma, 0.5f), maxDiffusionSigma);
+
+	initDevice();
+	if (!initSim()) return -1;
+
+	//start the reference from exactly what was uploaded to the device
+	ReferenceSim reference;
+	reference.init(mapWidth, mapHeight);
+	for (int i = 0; i < numSlimes; i++)
+	{
+		reference.addSlime(positions[i * 2], positions[i * 2 + 1], directions[i * 2], directions[i * 2 + 1],
+			randomSeeds[i]);
+	}
+
+	std::cout << "Validating " << (outOfCore ? "out-of-core" : "in-core") << " engine against reference: "
+		<< mapWidth << "x" << mapHeight << ", " << numSlimes << " slimes, " << validationSettings.steps
+		<< " steps, seed " << seed << std::endl;
+
+	size_t mapSize = (size_t)mapWidth * mapHeight;
+	bool trailDiverged = false;
+	bool agentsDiverged = false;
+	bool failed = false;
+	float worstMeanTrailDiff = 0.0f;
+	float worstMassDiff = 0.0f;
+	float worstDivergedFraction = 0.0f;
+
+	for (int step = 0; step < validationSettings.steps && !failed; step++)
+	{
+		stepSim();
+		reference.step(simDeltaTime, slimeSettings, trailSettings);
+
+		const float* deviceTrail;
+		if (outOfCore)
+		{
+			deviceTrail = hostTrailMap;
+		}
+		else
+		{
+			trailMap->read_from_device();
+			deviceTrail = trailMap->data();
+		}
+		positions.read_from_device();
+		directions.read_from_device();
+		randomSeeds.read_from_device();
+
+		//trail map
+		double totalDiff = 0.0, deviceMass = 0.0, referenceMass = 0.0;
+		float maxDiff = 0.0f;
+		size_t maxDiffIndex = 0;
+		for (size_t i = 0; i < mapSize; i++)
+		{
+			float diff = fabsf(deviceTrail[i] - reference.trailMap[i]);
+			totalDiff += diff;
+			deviceMass += deviceTrail[i];
+			referenceMass += reference.trailMap[i];
+			if (diff > maxDiff)
+			{
+				maxDiff = diff;
+				maxDiffIndex = i;
+			}
+		}
+
+		float meanTrailDiff = (float)(totalDiff / mapSize);
+		float massDiff = (float)(fabs(deviceMass - referenceMass) / std::max(referenceMass, 1e-6));
+
+		if (!trailDiverged && maxDiff > validationSettings.trailTolerance)
+		{
+			trailDiverged = true;
+			std::cout << "step " << step << ": trail map diverged at (" << maxDiffIndex % mapWidth << ", "
+				<< maxDiffIndex / mapWidth << "), device " << deviceTrail[maxDiffIndex] << ", reference "
+				<< reference.trailMap[maxDiffIndex] << std::endl;
+		}
+
+		//slimes, distances are measured across the wrapped edges
+		int numDiverged = 0;
+		for (int i = 0; i < numSlimes; i++)
+		{
+			if (randomSeeds[i] != reference.randomSeeds[i])
+			{
+				//the random numbers are integer only, so any difference is a real bug rather than rounding
+				std::cout << "step " << step << ": slime " << i << " random seed differs, device " << randomSeeds[i]
+					<< ", reference " << reference.randomSeeds[i] << std::endl;
+				failed = true;
+				break;
+			}
+
+			float dx = fabsf(positions[i * 2] - reference.positions[i * 2]);
+			float dy = fabsf(positions[i * 2 + 1] - reference.positions[i * 2 + 1]);
+			dx = std::min(dx, mapWidth - dx);
+			dy = std::min(dy, mapHeight - dy);
+			float distance = sqrtf(dx * dx + dy * dy);
+
+			//a wrong turn only moves the slime a step's distance off course, so check the direction too to catch it on
+			//the step it happens rather than once the positions have drifted apart
+			float ddx = directions[i * 2] - reference.directions[i * 2];
+			float ddy = directions[i * 2 + 1] - reference.directions[i * 2 + 1];
+			float directionDiff = sqrtf(ddx * ddx + ddy * ddy);
+
+			if (distance > validationSettings.agentTolerance || directionDiff > validationSettings.directionTolerance)
+			{
+				if (!agentsDiverged)
+				{
+					agentsDiverged = true;
+					std::cout << "step " << step << ": slime " << i << " diverged, device (" << positions[i * 2] << ", "
+						<< positions[i * 2 + 1] << ") heading (" << directions[i * 2] << ", " << directions[i * 2 + 1]
+						<< "), reference (" << reference.positions[i * 2] << ", " << reference.positions[i * 2 + 1]
+						<< ") heading (" << reference.directions[i * 2] << ", " << reference.directions[i * 2 + 1] << ")"
+						<< std::endl;
+				}
+				numDiverged++;
+			}
+		}
+
+		float divergedFraction = (float)numDiverged / numSlimes;
+		worstMeanTrailDiff = std::max(worstMeanTrailDiff, meanTrailDiff);
+		worstMassDiff = std::max(worstMassDiff, massDiff);
+		worstDivergedFraction = std::max(worstDivergedFraction, divergedFraction);
+
+		//individual pixels and slimes are expected to drift apart from rounding eventually, so unless strict only
+		//fail when the run as a whole stops matching
+		if (meanTrailDiff > validationSettings.meanTrailTolerance)
+		{
+			std::cout << "step " << step << ": mean trail difference " << meanTrailDiff << " exceeds "
+				<< validationSettings.meanTrailTolerance << std::endl;
+			failed = true;
+		}
+		if (massDiff > validationSettings.massTolerance)
+		{
+			std::cout << "step " << step << ": trail mass difference " << massDiff << " exceeds "
+				<< validationSettings.massTolerance << std::endl;
+			failed = true;
+		}
+		if (divergedFraction > validationSettings.divergedFraction)
+		{
+			std::cout << "step " << step << ": " << divergedFraction << " of slimes diverged, exceeds "
+				<< validationSettings.divergedFraction << std::endl;
+			failed = true;
+		}
+		if (validationSettings.strict && (trailDiverged || agentsDiverged)) failed = true;
+	}
+
+	std::cout << "worst mean trail difference " << worstMeanTrailDiff << ", worst trail mass difference "
+		<< worstMassDiff << ", worst diverged slime fraction " << worstDivergedFraction << std::endl;
+	std::cout << (failed ? "FAILED" : "PASSED") << std::endl;
+
+	destroySim();
+	return failed ? 1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc > 1 && std::string(argv[1]) == "--validate")
+	{
+		return runValidation(argc, argv);
+	}
+
 	srand(std::chrono::system_clock::now().time_since_epoch().count());
 
 	if (!initOnce())
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "string"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include "windows.h"
+#else
+#include "fcntl.h"
+#include "sys/mman.h"
+#include "unistd.h"
+#endif
+
+
+//array of floats backed by a file, so the OS can page it in and out instead of it all needing to fit in RAM
+class MappedFile
+{
+public:
+	float* data = nullptr;
+	size_t size = 0; //number of floats
+
+	bool open(const std::string& path, size_t numFloats)
+	{
+		close();
+		size_t bytes = numFloats * sizeof(float);
+
+#ifdef _WIN32
+		file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+			FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+		if (file == INVALID_HANDLE_VALUE) return false;
+
+		mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)(bytes >> 32), (DWORD)(bytes & 0xffffffff), NULL);
+		if (mapping == NULL)
+		{
+			close();
+			return false;
+		}
+
+		data = (float*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+#else
+		file = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (file < 0) return false;
+
+		//newly extended file contents read as zero, so the trail map starts empty
+		if (ftruncate(file, bytes) != 0)
+		{
+			close();
+			return false;
+		}
+
+		void* mapped = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+		data = mapped == MAP_FAILED ? nullptr : (float*)mapped;
+		unlink(path.c_str()); //only needed while mapped
+#endif
+
+		if (data == nullptr)
+		{
+			close();
+			return false;
+		}
+
+		size = numFloats;
+		return true;
+	}
+
+	void close()
+	{
+#ifdef _WIN32
+		if (data != nullptr) UnmapViewOfFile(data);
+		if (mapping != NULL) CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+		mapping = NULL;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if (data != nullptr) munmap(data, size * sizeof(float));
+		if (file >= 0) ::close(file);
+		file = -1;
+#endif
+		data = nullptr;
+		size = 0;
+	}
+
+	~MappedFile()
+	{
+		close();
+	}
+
+private:
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = NULL;
+#else
+	int file = -1;
+#endif
+};
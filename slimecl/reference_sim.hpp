@@ -0,0 +1,273 @@
+#pragma once
+
+#include "algorithm"
+#include "cmath"
+#include "cstdint"
+#include "vector"
+
+#include "sim_settings.hpp"
+
+
+//straightforward single threaded version of the kernels in kernel.cpp, used as the reference that the device
+//engines are checked against. keep it doing the same operations in the same order as the kernels, so any
+//difference left is floating point rounding rather than a change in behaviour
+class ReferenceSim
+{
+public:
+	int mapWidth = 0;
+	int mapHeight = 0;
+
+	//interleaved x, y like the device buffers
+	std::vector<float> positions, directions;
+	std::vector<uint32_t> randomSeeds;
+	std::vector<float> trailMap, nextTrailMap;
+	std::vector<float> blurA, blurB; //scratch for the separable diffusion passes
+
+	void init(int width, int height)
+	{
+		mapWidth = width;
+		mapHeight = height;
+		positions.clear();
+		directions.clear();
+		randomSeeds.clear();
+		trailMap.assign((size_t)mapWidth * mapHeight, 0.0f);
+		nextTrailMap.assign((size_t)mapWidth * mapHeight, 0.0f);
+		blurA.assign((size_t)mapWidth * mapHeight, 0.0f);
+		blurB.assign((size_t)mapWidth * mapHeight, 0.0f);
+	}
+
+	void addSlime(float x, float y, float dx, float dy, uint32_t seed)
+	{
+		positions.push_back(x);
+		positions.push_back(y);
+		directions.push_back(dx);
+		directions.push_back(dy);
+		randomSeeds.push_back(seed);
+	}
+
+	int numSlimes() const
+	{
+		return (int)randomSeeds.size();
+	}
+
+	void step(float simDeltaTime, const SlimeSettings& slimeSettings, const TrailSettings& trailSettings)
+	{
+		int radii[3];
+		int passes = diffusionPassRadii(trailSettings, radii);
+
+		if (passes == 0)
+		{
+			for (int y = 0; y < mapHeight; y++)
+			{
+				for (int x = 0; x < mapWidth; x++)
+				{
+					nextTrailMap[(size_t)y * mapWidth + x] = decayPixel(x, y, wrap(y - 1, mapHeight),
+						wrap(y + 1, mapHeight), simDeltaTime, trailSettings);
+				}
+			}
+		}
+		else
+		{
+			const std::vector<float>* src = &trailMap;
+			for (int pass = 0; pass < passes; pass++)
+			{
+				blurRows(*src, blurA, radii[pass]);
+				blurColumns(blurA, blurB, radii[pass]);
+				src = &blurB;
+			}
+
+			for (size_t i = 0; i < trailMap.size(); i++)
+			{
+				nextTrailMap[i] = decayValue(trailMap[i], blurB[i], simDeltaTime, trailSettings);
+			}
+		}
+
+		for (int slimeIndex = 0; slimeIndex < numSlimes(); slimeIndex++)
+		{
+			updateSlime(slimeIndex, simDeltaTime, slimeSettings);
+		}
+
+		std::swap(trailMap, nextTrailMap);
+	}
+
+private:
+	static int wrap(int x, const int period)
+	{
+		while (x < 0) x += period;
+		while (x >= period) x -= period;
+		return x;
+	}
+
+	void wrapPos(float& x, float& y) const
+	{
+		while (x < 0) x += mapWidth;
+		while (x >= mapWidth) x -= mapWidth;
+		while (y < 0) y += mapHeight;
+		while (y >= mapHeight) y -= mapHeight;
+	}
+
+	static uint32_t randomInt(uint32_t seed)
+	{
+		//https://www.cs.ubc.ca/~rbridson/docs/schechter-sca08-turbulence.pdf
+		seed ^= 2747636419u;
+		seed *= 2654435769u;
+		seed ^= seed >> 16;
+		seed *= 2654435769u;
+		seed ^= seed >> 16;
+		seed *= 2654435769u;
+		return seed;
+	}
+
+	static float random01(uint32_t val)
+	{
+		//random float between 0 and 1
+		return (float)val / 4294967296.0f;
+	}
+
+	static void rotate(float x, float y, float angle, float& outX, float& outY)
+	{
+		outX = x * cosf(angle) - y * sinf(angle);
+		outY = x * sinf(angle) + y * cosf(angle);
+	}
+
+	static void normalize(float& x, float& y)
+	{
+		float l = sqrtf(x * x + y * y);
+		x /= l;
+		y /= l;
+	}
+
+	static float decayValue(float current, float average, float simDeltaTime, const TrailSettings& trailSettings)
+	{
+		float weight = trailSettings.blurRate * simDeltaTime;
+		float weightedAverage = (1.0f - weight) * current + weight * average;
+		return std::max(0.0f, weightedAverage - trailSettings.decayRate * simDeltaTime);
+	}
+
+	float decayPixel(int x, int y, int yUp, int yDown, float simDeltaTime, const TrailSettings& trailSettings) const
+	{
+		int xLeft = wrap(x - 1, mapWidth);
+		int xRight = wrap(x + 1, mapWidth);
+
+		//3x3 box blur
+		float average = (
+			trailMap[(size_t)yUp * mapWidth + xLeft] +
+			trailMap[(size_t)yUp * mapWidth + x] +
+			trailMap[(size_t)yUp * mapWidth + xRight] +
+			trailMap[(size_t)y * mapWidth + xLeft] +
+			trailMap[(size_t)y * mapWidth + x] +
+			trailMap[(size_t)y * mapWidth + xRight] +
+			trailMap[(size_t)yDown * mapWidth + xLeft] +
+			trailMap[(size_t)yDown * mapWidth + x] +
+			trailMap[(size_t)yDown * mapWidth + xRight]
+		) / 9.0f;
+
+		return decayValue(trailMap[(size_t)y * mapWidth + x], average, simDeltaTime, trailSettings);
+	}
+
+	void blurRows(const std::vector<float>& src, std::vector<float>& dst, int radius)
+	{
+		for (int y = 0; y < mapHeight; y++) blurLine(&src[(size_t)y * mapWidth], &dst[(size_t)y * mapWidth], mapWidth, 1, radius);
+	}
+
+	void blurColumns(const std::vector<float>& src, std::vector<float>& dst, int radius)
+	{
+		for (int x = 0; x < mapWidth; x++) blurLine(&src[x], &dst[x], mapHeight, mapWidth, radius);
+	}
+
+	void blurLine(const float* src, float* dst, int length, size_t stride, int radius)
+	{
+		//box blur of one wrapping row or column as a sliding sum in double precision. unlike the rest of the reference
+		//this deliberately doesn't follow the kernels, which sum in float in whatever order suits the device, so it
+		//checks the blur's result rather than repeating its method, and the validation tolerances cover the rounding
+		double sum = 0.0;
+		for (int i = -radius; i <= radius; i++) sum += src[wrap(i, length) * stride];
+
+		double scale = 1.0 / (2 * radius + 1);
+		for (int i = 0; i < length; i++)
+		{
+			dst[i * stride] = (float)(sum * scale);
+			sum += (double)src[wrap(i + radius + 1, length) * stride] - src[wrap(i - radius, length) * stride];
+		}
+	}
+
+	void updateSlime(int slimeIndex, float simDeltaTime, const SlimeSettings& slimeSettings)
+	{
+		float& px = positions[slimeIndex * 2];
+		float& py = positions[slimeIndex * 2 + 1];
+		float& dirX = directions[slimeIndex * 2];
+		float& dirY = directions[slimeIndex * 2 + 1];
+		uint32_t& seed = randomSeeds[slimeIndex];
+
+		//find which sensor is the strongest
+		float sensorStrength[3] = { 0, 0, 0 };
+		int sensorWidth = 1 + 2 * slimeSettings.sensorRadius;
+		int sensorSize = sensorWidth * sensorWidth; //number of pixels in sensor
+		for (int sensorIndex = 0; sensorIndex < 3; sensorIndex++)
+		{
+			float sensorDirX, sensorDirY;
+			rotate(dirX, dirY, slimeSettings.sensorAngle * (sensorIndex - 1), sensorDirX, sensorDirY);
+			int sensorX = (int)(px + sensorDirX * 3.5f * slimeSettings.sensorRadius);
+			int sensorY = (int)(py + sensorDirY * 3.5f * slimeSettings.sensorRadius);
+
+			for (int di = 0; di < sensorSize; di++)
+			{
+				//dx and dy range from -sensorRadius to +sensorRadius
+				int dx = di % sensorWidth - slimeSettings.sensorRadius;
+				int dy = di / sensorWidth - slimeSettings.sensorRadius;
+				int sx = wrap(sensorX + dx, mapWidth);
+				int sy = wrap(sensorY + dy, mapHeight);
+
+				sensorStrength[sensorIndex] += trailMap[(size_t)sy * mapWidth + sx];
+			}
+		}
+
+		//if all 3 are the same, default to 1 for straight ahead
+		int strongestIndex = sensorStrength[0] > sensorStrength[1] ? 0 : 1;
+		strongestIndex = sensorStrength[strongestIndex] >= sensorStrength[2] ? strongestIndex : 2;
+
+		//turn towards strongest sensor, dont turn if straight ahead
+		if (strongestIndex != 1)
+		{
+			float strongestX, strongestY;
+			rotate(dirX, dirY, slimeSettings.sensorAngle * (strongestIndex - 1), strongestX, strongestY);
+			dirX = slimeSettings.sensorTurnStrength * strongestX + (1.0f - slimeSettings.sensorTurnStrength) * dirX;
+			dirY = slimeSettings.sensorTurnStrength * strongestY + (1.0f - slimeSettings.sensorTurnStrength) * dirY;
+			normalize(dirX, dirY);
+		}
+
+		//turn a little towards a random direction
+		seed = randomInt(seed);
+		float rdx = random01(seed) - 0.5f;
+
+		seed = randomInt(seed);
+		float rdy = random01(seed) - 0.5f;
+
+		normalize(rdx, rdy);
+		dirX = slimeSettings.directionRandomness * rdx + (1.0f - slimeSettings.directionRandomness) * dirX;
+		dirY = slimeSettings.directionRandomness * rdy + (1.0f - slimeSettings.directionRandomness) * dirY;
+		normalize(dirX, dirY);
+
+		//move along new direction
+		px += slimeSettings.slimeSpeed * dirX * simDeltaTime;
+		py += slimeSettings.slimeSpeed * dirY * simDeltaTime;
+		wrapPos(px, py);
+
+		//set trail map strength at position to 1
+		nextTrailMap[(size_t)wrap((int)py, mapHeight) * mapWidth + wrap((int)px, mapWidth)] = 1.0f;
+
+		if (slimeSettings.depositWidth > 0)
+		{
+			//get direction perpendicular to slime forward
+			float perpX = -dirY;
+			float perpY = dirX;
+			for (float w = -slimeSettings.depositWidth; w <= slimeSettings.depositWidth; w++)
+			{
+				float depositX = px + w * perpX;
+				float depositY = py + w * perpY;
+				wrapPos(depositX, depositY);
+				nextTrailMap[(size_t)wrap((int)depositY, mapHeight) * mapWidth + wrap((int)depositX, mapWidth)] = 1.0f;
+			}
+		}
+	}
+};
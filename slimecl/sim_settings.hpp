@@ -0,0 +1,120 @@
+#pragma once
+
+#include "cmath"
+
+
+//layouts must match the structs of the same name in kernel.cpp, as they are passed straight to the kernels
+
+struct SlimeSettings
+{
+	float slimeSpeed;
+	int sensorRadius;
+	float sensorAngle;
+	float sensorTurnStrength;
+	float directionRandomness;
+	int depositWidth;
+};
+
+enum DiffusionMode
+{
+	DIFFUSION_3X3 = 0, //original 3x3 box blur
+	DIFFUSION_BOX = 1, //square box blur of diffusionRadius
+	DIFFUSION_GAUSSIAN = 2 //gaussian blur of diffusionSigma, approximated by 3 box blurs
+};
+
+struct TrailSettings
+{
+	float blurRate;
+	float decayRate;
+	float r, g, b;
+	int diffusionMode;
+	int diffusionRadius;
+	float diffusionSigma;
+};
+
+enum BlurLayout
+{
+	BLUR_ROW_TILE = 256, //blurRows work groups each blur this many pixels of a row
+	BLUR_ROW_GROUP = 128, //blurRows work groups are this many work items
+	BLUR_MAX_RADIUS = 64, //largest radius of one pass, sizes the local memory of blurRows
+	BLUR_COLUMN_RUN = 32 //blurColumns work items each blur this many rows of a column
+};
+
+//largest diffusion the settings allow, the total radius of all blur passes stays within maxDiffusionReach
+const int maxDiffusionRadius = 64;
+const float maxDiffusionSigma = 20.0f;
+const int maxDiffusionReach = 64;
+
+//radius of each separable box blur pass, returns the number of passes (0 for the 3x3 box, which isn't separated and
+//which a small enough gaussian falls back to)
+inline int diffusionPassRadii(const TrailSettings& trailSettings, int radii[3])
+{
+	if (trailSettings.diffusionMode == DIFFUSION_BOX)
+	{
+		radii[0] = trailSettings.diffusionRadius;
+		return 1;
+	}
+
+	if (trailSettings.diffusionMode == DIFFUSION_GAUSSIAN)
+	{
+		//box widths whose repeated blur has the closest variance to the gaussian
+		//http://blog.ivank.net/fastest-gaussian-blur.html
+		const int n = 3;
+		float sigma = trailSettings.diffusionSigma;
+		int lowerWidth = (int)floorf(sqrtf(12.0f * sigma * sigma / n + 1.0f));
+		if (lowerWidth % 2 == 0) lowerWidth--;
+		int upperWidth = lowerWidth + 2;
+		float idealLowerPasses = (12.0f * sigma * sigma - n * lowerWidth * lowerWidth - 4.0f * n * lowerWidth - 3.0f * n) /
+			(-4.0f * lowerWidth - 4.0f);
+		int lowerPasses = (int)roundf(idealLowerPasses);
+
+		//below a sigma of about 0.6 the narrower boxes are a single pixel wide and blur nothing, so leave those passes
+		//out. if that's all of them, the 3x3 box is the same as the one pass of width 3 the next sigma up would give
+		int passes = 0;
+		for (int i = 0; i < n; i++)
+		{
+			int radius = ((i < lowerPasses ? lowerWidth : upperWidth) - 1) / 2;
+			if (radius > 0) radii[passes++] = radius;
+		}
+		return passes;
+	}
+
+	return 0;
+}
+
+//rows or columns the blur passes reach from a pixel in total
+inline int diffusionReach(const TrailSettings& trailSettings)
+{
+	int radii[3];
+	int passes = diffusionPassRadii(trailSettings, radii);
+	int reach = 0;
+	for (int i = 0; i < passes; i++) reach += radii[i];
+	return reach;
+}
+
+//shared by every engine so they start from the same parameters
+inline SlimeSettings defaultSlimeSettings()
+{
+	SlimeSettings slimeSettings;
+	slimeSettings.slimeSpeed = 5.0f; //number of pixels per 1 second of sim time
+	slimeSettings.sensorRadius = 2; //size in pixels of sensor box width in each direction from centre (e.g. sensorRadius = 2, box is 5x5)
+	slimeSettings.sensorAngle = 3.14159265f * 0.25f; //angle from direction of slime to left/right sensors
+	slimeSettings.sensorTurnStrength = 0.3f; //how strongly the slime turns towards the strongest sensor
+	slimeSettings.directionRandomness = 0.1f; //how much randomness changes the slime's direction
+	slimeSettings.depositWidth = 0; //how many pixels each side of the slime to leave a trail on
+	return slimeSettings;
+}
+
+inline TrailSettings defaultTrailSettings()
+{
+	TrailSettings trailSettings;
+	trailSettings.blurRate = 0.2f;
+	trailSettings.decayRate = 0.005f;
+	trailSettings.r = 0.2f;
+	trailSettings.g = 1.0f;
+	trailSettings.b = 0.6f;
+	trailSettings.diffusionMode = DIFFUSION_3X3;
+	trailSettings.diffusionRadius = 4; //pixels each side of the centre for DIFFUSION_BOX
+	trailSettings.diffusionSigma = 4.0f; //standard deviation in pixels for DIFFUSION_GAUSSIAN
+	return trailSettings;
+}